@@ -0,0 +1,58 @@
+// Times CADMesh's STLReader on an ASCII STL file and counts the heap
+// allocations it makes, e.g.
+//
+//   ./cadmesh_bench Body98.stl 5
+//
+// Body98.stl is under CADMESH_PARALLEL_PARSE_MIN_BYTES, so this goes
+// through the lexer. Built with -DBUILD_BENCH=ON
+// GCC can't tell that the replacements below pair malloc() with free(), and
+// warns at every inlined delete
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+#include "CADMesh.hh"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+  std::size_t allocations = 0;
+}
+
+// Counts every allocation in the process; the bench is single-threaded
+// outside the reader, and the lexer path doesn't start any threads
+void* operator new(std::size_t size) {
+  ++allocations;
+  if (void* ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "Usage: %s <file.stl> [repeats]\n", argv[0]);
+    return 1;
+  }
+  int repeats = argc > 2 ? std::atoi(argv[2]) : 3;
+  for (int i = 0; i < repeats; ++i) {
+    allocations = 0;
+    auto start = std::chrono::steady_clock::now();
+    CADMesh::File::STLReader reader;
+    reader.Read(argv[1]);
+    std::chrono::duration<double, std::milli> time =
+      std::chrono::steady_clock::now() - start;
+    std::printf("%zu triangles, %.1f ms, %zu allocations\n",
+        reader.GetMesh()->GetNumberOfTriangles(), time.count(), allocations);
+  }
+  return 0;
+}
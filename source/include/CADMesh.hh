@@ -93,38 +93,69 @@ Type TypeFromName(G4String name);
 #include "G4ThreeVector.hh"
 #include "G4TriangularFacet.hh"
 
+#include <array>
+#include <cstdint>
 #include <memory>
+#include <queue>
+#include <unordered_map>
 #include <vector>
 
 namespace CADMesh {
 
 typedef std::vector<G4ThreeVector> Points;
-typedef std::vector<G4TriangularFacet *> Triangles;
+// Three indices into a Points array per triangle.
+typedef std::vector<size_t> Indices;
 
+// What Mesh::Check found. Geant4 can only navigate a tessellated solid
+// safely when every edge is shared by exactly two facets and no facet is
+// degenerate.
+struct MeshCheck {
+  size_t open_edges = 0;         // edges used by one facet
+  size_t non_manifold_edges = 0; // edges used by three or more facets
+  size_t degenerate_facets = 0;  // repeated vertex or zero area
+
+  G4bool IsValid() const {
+    return open_edges == 0 && non_manifold_edges == 0 &&
+           degenerate_facets == 0;
+  }
+};
+
+// A triangle mesh, stored as each distinct vertex once plus an index buffer.
+// G4TriangularFacets are only made when TessellatedMesh builds the solid.
 class Mesh {
 public:
-  Mesh(Points points, Triangles triangles, G4String name = "");
+  Mesh(Points points, Indices indices, G4String name = "");
 
-  static std::shared_ptr<Mesh> New(Points points, Triangles triangles,
+  static std::shared_ptr<Mesh> New(Points points, Indices indices,
                                    G4String name = "");
 
-  static std::shared_ptr<Mesh> New(Triangles triangles, G4String name = "");
+  // corners holds three points per triangle, which is how STL and most
+  // readers see them; identical points are merged into one vertex.
+  static std::shared_ptr<Mesh> FromCorners(const Points &corners,
+                                           G4String name = "");
 
   static std::shared_ptr<Mesh> New(std::shared_ptr<Mesh> mesh,
                                    G4String name = "");
 
 public:
   G4String GetName();
-  Points GetPoints();
-  Triangles GetTriangles();
+  const Points &GetPoints();
+  const Indices &GetIndices();
+  size_t GetNumberOfTriangles();
 
+  MeshCheck Check();
   G4bool IsValidForNavigation();
 
+  // Quadric-error edge collapse. Returns a simplified copy in which no
+  // vertex has moved further than tolerance from the planes of the facets
+  // it replaced. Edges that are open or non-manifold are left alone.
+  std::shared_ptr<Mesh> Decimate(G4double tolerance);
+
 private:
   G4String name_ = "";
 
   Points points_;
-  Triangles triangles_;
+  Indices indices_;
 };
 
 typedef std::vector<std::shared_ptr<Mesh>> Meshes;
@@ -167,6 +198,7 @@ private:
 
 #include <iostream>
 #include <string>
+#include <string_view>
 
 namespace CADMesh {
 
@@ -175,8 +207,8 @@ namespace File {
 struct Token {
   std::string name;
 
-  bool operator==(Token other) { return name == other.name; };
-  bool operator!=(Token other) { return name != other.name; };
+  bool operator==(const Token &other) const { return name == other.name; };
+  bool operator!=(const Token &other) const { return name != other.name; };
 };
 
 static Token ErrorToken{"ErrorToken"};
@@ -224,33 +256,63 @@ struct __FinalState : public State {
   State *operator()(Lexer *) const { return nullptr; }
 };
 
+// Read-only view of a whole file: memory-mapped where possible, otherwise
+// read into a string.
+class MappedFile {
+public:
+  MappedFile(std::string filepath);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  std::string_view View() const { return view_; }
+
+private:
+  std::string_view view_;
+  std::string buffer_;
+  void *mapped_ = nullptr;
+  size_t mapped_size_ = 0;
+};
+
+// States hold no data, so a single shared instance of each is enough.
+template <typename T> State *StateInstance() {
+  static T state;
+  return &state;
+}
+
 class Lexer {
 public:
   Lexer(std::string filepath, State *initial_state = nullptr);
 
+  Lexer(const Lexer &) = delete;
+  Lexer &operator=(const Lexer &) = delete;
+
 public:
   std::string String();
 
   void Run(State *initial_state, size_t lines = 0);
-  Items GetItems();
+  // Valid for as long as the lexer is; each Run() keeps its own items.
+  const Items &GetItems();
 
   void Backup();
   void BackupTo(int position);
 
-  std::string Next();
-  std::string Peek();
+  // Both return '\0' at the end of the input.
+  char Next();
+  char Peek();
 
   void Skip();
 
-  Item *ThisIsA(Token token, std::string error = "");
-  Item *StartOfA(Token token, std::string error = "");
-  Item *EndOfA(Token token, std::string error = "");
-  Item *MaybeEndOfA(Token token, std::string error = "");
+  Item *ThisIsA(const Token &token, const std::string &error = "");
+  Item *StartOfA(const Token &token, const std::string &error = "");
+  Item *EndOfA(const Token &token, const std::string &error = "");
+  Item *MaybeEndOfA(const Token &token, const std::string &error = "");
 
-  bool OneOf(std::string possibles);
-  bool ManyOf(std::string possibles);
-  bool Until(std::string match);
-  bool MatchExactly(std::string match);
+  bool OneOf(std::string_view possibles);
+  bool ManyOf(std::string_view possibles);
+  bool Until(std::string_view match);
+  bool MatchExactly(std::string_view match);
 
   bool OneDigit();
   bool ManyDigits();
@@ -277,7 +339,7 @@ public:
   bool IsDryRun();
 
   void PrintMessage(std::string name, std::string message);
-  void PrintItem(Item item);
+  void PrintItem(const Item &item);
 
   size_t LineNumber();
 
@@ -286,8 +348,10 @@ private:
 
   Item *parent_item_ = nullptr;
   Items items_;
+  std::vector<std::unique_ptr<Item>> roots_;
 
-  std::string input_;
+  MappedFile file_;
+  std::string_view input_;
 
   size_t position_ = 0;
   size_t start_ = 0;
@@ -424,6 +488,8 @@ public:
   void SetOffset(G4ThreeVector offset);
   G4ThreeVector GetOffset();
 
+  std::shared_ptr<File::Reader> GetReader();
+
 protected:
   G4String file_name_;
   File::Type file_type_;
@@ -454,6 +520,8 @@ void ReaderCantReadError(G4String origin, File::Type file_type,
 
 void MeshNotFound(G4String origin, size_t index);
 void MeshNotFound(G4String origin, G4String name);
+
+void InvalidMesh(G4String origin, G4String name, const MeshCheck &check);
 }
 }
 
@@ -481,8 +549,17 @@ public:
 
   G4bool GetReverse() { return this->reverse_; };
 
+  // Maximum deviation allowed when simplifying meshes before building the
+  // solid, in the same units as the scaled mesh. Zero keeps every facet.
+  void SetDecimationTolerance(G4double tolerance) {
+    this->decimation_tolerance_ = tolerance;
+  };
+
+  G4double GetDecimationTolerance() { return this->decimation_tolerance_; };
+
 private:
   G4bool reverse_;
+  G4double decimation_tolerance_ = 0;
 };
 }
 
@@ -528,9 +605,9 @@ private:
   std::shared_ptr<tetgenio> in_ = nullptr;
   std::shared_ptr<tetgenio> out_ = nullptr;
 
-  G4double quality_;
+  G4double quality_ = 0;
 
-  G4Material *material_;
+  G4Material *material_ = nullptr;
 };
 }
 #endif
@@ -562,82 +639,454 @@ inline Type TypeFromName(G4String name) {
 
 namespace CADMesh {
 
-inline Mesh::Mesh(Points points, Triangles triangles, G4String name)
-    : name_(name), points_(points), triangles_(triangles) {}
+inline Mesh::Mesh(Points points, Indices indices, G4String name)
+    : name_(name), points_(std::move(points)), indices_(std::move(indices)) {}
 
-inline std::shared_ptr<Mesh> Mesh::New(Points points, Triangles triangles,
+inline std::shared_ptr<Mesh> Mesh::New(Points points, Indices indices,
                                        G4String name) {
-  return std::make_shared<Mesh>(points, triangles, name);
+  return std::make_shared<Mesh>(std::move(points), std::move(indices), name);
 }
 
-inline std::shared_ptr<Mesh> Mesh::New(Triangles triangles, G4String name) {
+inline std::shared_ptr<Mesh> Mesh::FromCorners(const Points &corners,
+                                               G4String name) {
+  struct PointHash {
+    size_t operator()(const G4ThreeVector &point) const {
+      std::hash<G4double> hash;
+      return hash(point.x()) ^ (hash(point.y()) * 31) ^ (hash(point.z()) * 961);
+    }
+  };
+
+  std::unordered_map<G4ThreeVector, size_t, PointHash> point_index;
+  point_index.reserve(corners.size() / 2);
+
   Points points;
+  Indices indices;
+  indices.reserve(corners.size());
+
+  for (const auto &corner : corners) {
+    auto inserted = point_index.emplace(corner, points.size());
+
+    if (inserted.second) {
+      points.push_back(corner);
+    }
+
+    indices.push_back(inserted.first->second);
+  }
 
-  return New(points, triangles, name);
+  return New(std::move(points), std::move(indices), name);
 }
 
 inline std::shared_ptr<Mesh> Mesh::New(std::shared_ptr<Mesh> mesh,
                                        G4String name) {
-  return New(mesh->GetPoints(), mesh->GetTriangles(), name);
+  return New(mesh->GetPoints(), mesh->GetIndices(), name);
 }
 
 inline G4String Mesh::GetName() { return name_; }
 
-inline Points Mesh::GetPoints() { return points_; }
+inline const Points &Mesh::GetPoints() { return points_; }
+
+inline const Indices &Mesh::GetIndices() { return indices_; }
+
+inline size_t Mesh::GetNumberOfTriangles() { return indices_.size() / 3; }
+
+inline MeshCheck Mesh::Check() {
+  MeshCheck check;
+
+  // Each edge becomes one key with the lower vertex index first, so the
+  // two facets sharing it produce the same key. Sorting the keys puts the
+  // uses of an edge next to each other, and the run lengths are the counts.
+  auto count_edges = [&](auto make_key) {
+    std::vector<decltype(make_key(0, 0))> edges;
+    edges.reserve(indices_.size());
+
+    for (size_t i = 0; i < indices_.size(); i += 3) {
+      size_t a = indices_[i];
+      size_t b = indices_[i + 1];
+      size_t c = indices_[i + 2];
+
+      if (a == b || b == c || c == a) {
+        check.degenerate_facets++;
+        continue;
+      }
+
+      auto &pa = points_[a];
+      auto normal = (points_[b] - pa).cross(points_[c] - pa);
+
+      if (normal.mag2() == 0) {
+        check.degenerate_facets++;
+      }
+
+      edges.push_back(make_key(std::min(a, b), std::max(a, b)));
+      edges.push_back(make_key(std::min(b, c), std::max(b, c)));
+      edges.push_back(make_key(std::min(c, a), std::max(c, a)));
+    }
+
+    std::sort(edges.begin(), edges.end());
+
+    for (size_t i = 0; i < edges.size();) {
+      size_t j = i + 1;
+
+      while (j < edges.size() && edges[j] == edges[i]) {
+        j++;
+      }
+
+      if (j - i == 1) {
+        check.open_edges++;
+      }
+
+      else if (j - i > 2) {
+        check.non_manifold_edges++;
+      }
+
+      i = j;
+    }
+  };
+
+  if (points_.size() <= 0xffffffff) {
+    count_edges([](size_t a, size_t b) { return (uint64_t)a << 32 | b; });
+  }
+
+  else {
+    count_edges([](size_t a, size_t b) { return std::make_pair(a, b); });
+  }
+
+  return check;
+}
+
+inline G4bool Mesh::IsValidForNavigation() { return Check().IsValid(); }
+
+namespace Decimation {
+
+// Symmetric 4x4 matrix summing the squared distances to a set of planes,
+// stored as its upper triangle.
+struct Quadric {
+  std::array<G4double, 10> q = {};
+
+  void AddPlane(const G4ThreeVector &normal, G4double d) {
+    G4double p[4] = {normal.x(), normal.y(), normal.z(), d};
+
+    for (size_t i = 0, k = 0; i < 4; i++) {
+      for (size_t j = i; j < 4; j++, k++) {
+        q[k] += p[i] * p[j];
+      }
+    }
+  }
+
+  Quadric operator+(const Quadric &other) const {
+    Quadric sum;
+
+    for (size_t k = 0; k < 10; k++) {
+      sum.q[k] = q[k] + other.q[k];
+    }
+
+    return sum;
+  }
+
+  G4double Error(const G4ThreeVector &v) const {
+    G4double x = v.x(), y = v.y(), z = v.z();
+
+    return q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z +
+           2 * q[3] * x + q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y +
+           q[7] * z * z + 2 * q[8] * z + q[9];
+  }
+
+  // The point minimising Error, if the planes pin one down.
+  G4bool Optimum(G4ThreeVector &v) const {
+    G4double a = q[0], b = q[1], c = q[2], d = q[4], e = q[5], f = q[7];
+    G4double det = a * (d * f - e * e) - b * (b * f - c * e) +
+                   c * (b * e - c * d);
+
+    if (std::abs(det) < 1e-12 * (a * d * f + 1e-300)) {
+      return false;
+    }
+
+    G4double rx = -q[3], ry = -q[6], rz = -q[8];
+
+    v = G4ThreeVector(
+        (rx * (d * f - e * e) - b * (ry * f - e * rz) + c * (ry * e - d * rz)) /
+            det,
+        (a * (ry * f - e * rz) - rx * (b * f - c * e) + c * (b * rz - ry * c)) /
+            det,
+        (a * (d * rz - ry * e) - b * (b * rz - ry * c) + rx * (b * e - c * d)) /
+            det);
+
+    return true;
+  }
+};
+
+// Kept small, since there are several per edge in the queue. The target
+// position is worked out again when the collapse is applied.
+struct Collapse {
+  G4double error;
+  uint32_t u, v;
+  uint32_t u_version, v_version;
+
+  G4bool operator>(const Collapse &other) const {
+    return error > other.error;
+  }
+};
+}
 
-inline Triangles Mesh::GetTriangles() { return triangles_; }
+inline std::shared_ptr<Mesh> Mesh::Decimate(G4double tolerance) {
+  using Decimation::Collapse;
+  using Decimation::Quadric;
 
-inline G4bool Mesh::IsValidForNavigation() {
-  std::map<G4ThreeVector, size_t> point_index;
+  size_t n_points = points_.size();
+  size_t n_faces = indices_.size() / 3;
 
-  size_t index = 0;
-  for (auto point : points_) {
-    point_index[point] = index;
-    index++;
+  if (n_points > 0xffffffff) {
+    return New(points_, indices_, name_);
   }
 
-  typedef std::pair<size_t, size_t> Edge;
-  std::map<Edge, G4int> edge_use_count;
+  Points position = points_;
+  std::vector<Quadric> quadrics(n_points);
+  std::vector<G4bool> locked(n_points, false), point_removed(n_points, false);
+  std::vector<uint32_t> version(n_points, 0);
+
+  std::vector<std::array<size_t, 3>> faces(n_faces);
+  std::vector<G4bool> face_removed(n_faces, false);
+  std::vector<std::vector<size_t>> point_faces(n_points);
+
+  for (size_t f = 0; f < n_faces; f++) {
+    faces[f] = {indices_[3 * f], indices_[3 * f + 1], indices_[3 * f + 2]};
 
-  for (size_t i = 0; i < triangles_.size(); i++) {
-    auto triangle = triangles_[i];
+    auto &a = position[faces[f][0]];
+    auto normal =
+        (position[faces[f][1]] - a).cross(position[faces[f][2]] - a);
 
-    size_t a = point_index[triangle->GetVertex(0)];
-    size_t b = point_index[triangle->GetVertex(1)];
-    size_t c = point_index[triangle->GetVertex(2)];
+    for (auto index : faces[f]) {
+      point_faces[index].push_back(f);
 
-    if (a < b) {
-      edge_use_count[Edge(a, b)] += 1;
+      if (normal.mag2() > 0) {
+        quadrics[index].AddPlane(normal.unit(), -normal.unit().dot(a));
+      }
+    }
+  }
+
+  // Only edges shared by exactly two facets are collapsed, and the
+  // vertices of any other edge stay where they are.
+  std::vector<std::pair<size_t, size_t>> edges;
+  edges.reserve(indices_.size());
+
+  for (auto &face : faces) {
+    for (size_t i = 0; i < 3; i++) {
+      size_t a = face[i], b = face[(i + 1) % 3];
+      edges.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
     }
+  }
+
+  std::sort(edges.begin(), edges.end());
+
+  auto evaluate = [&](size_t u, size_t v, G4ThreeVector &target) {
+    auto quadric = quadrics[u] + quadrics[v];
+    auto midpoint = (position[u] + position[v]) / 2.;
 
-    else if (a > b) {
-      edge_use_count[Edge(b, a)] += 1;
+    target = midpoint;
+    G4double error = quadric.Error(midpoint);
+
+    G4ThreeVector optimum;
+    G4ThreeVector candidates[3] = {position[u], position[v], midpoint};
+
+    // Keep the optimum only when it lies near the edge; flat and
+    // cylindrical patches leave it far away or undefined.
+    if (quadric.Optimum(optimum) &&
+        (optimum - midpoint).mag2() <= (position[u] - position[v]).mag2()) {
+      candidates[2] = optimum;
     }
 
-    if (b < c) {
-      edge_use_count[Edge(b, c)] += 1;
+    for (auto &candidate : candidates) {
+      auto candidate_error = quadric.Error(candidate);
+
+      if (candidate_error < error) {
+        error = candidate_error;
+        target = candidate;
+      }
     }
 
-    else if (b > c) {
-      edge_use_count[Edge(c, b)] += 1;
+    return std::max(error, 0.);
+  };
+
+  auto make_collapse = [&](size_t u, size_t v) {
+    G4ThreeVector target;
+
+    return Collapse{evaluate(u, v, target), (uint32_t)u, (uint32_t)v,
+                    version[u], version[v]};
+  };
+
+  std::vector<std::pair<size_t, size_t>> manifold_edges;
+
+  for (size_t i = 0; i < edges.size();) {
+    size_t j = i + 1;
+
+    while (j < edges.size() && edges[j] == edges[i]) {
+      j++;
     }
 
-    if (c < a) {
-      edge_use_count[Edge(c, a)] += 1;
+    if (j - i != 2) {
+      locked[edges[i].first] = true;
+      locked[edges[i].second] = true;
     }
 
-    else if (c > a) {
-      edge_use_count[Edge(a, c)] += 1;
+    else if (edges[i].first != edges[i].second) {
+      manifold_edges.push_back(edges[i]);
     }
+
+    i = j;
   }
 
-  for (auto count : edge_use_count) {
-    if (count.second != 2) {
-      return false;
+  std::vector<Collapse> initial;
+  initial.reserve(manifold_edges.size());
+
+  for (auto &edge : manifold_edges) {
+    if (!locked[edge.first] && !locked[edge.second]) {
+      initial.push_back(make_collapse(edge.first, edge.second));
     }
   }
 
-  return true;
+  std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>>
+      queue(std::greater<Collapse>(), std::move(initial));
+
+  auto neighbours = [&](size_t u) {
+    std::vector<size_t> result;
+
+    for (auto f : point_faces[u]) {
+      for (auto index : faces[f]) {
+        if (index != u) {
+          result.push_back(index);
+        }
+      }
+    }
+
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+
+    return result;
+  };
+
+  // Facets around u and v that survive the collapse must not flip over or
+  // become slivers.
+  auto keeps_orientation = [&](size_t moved, size_t other,
+                               const G4ThreeVector &target) {
+    for (auto f : point_faces[moved]) {
+      auto &face = faces[f];
+
+      if (face[0] == other || face[1] == other || face[2] == other) {
+        continue;
+      }
+
+      G4ThreeVector corners[3];
+
+      for (size_t i = 0; i < 3; i++) {
+        corners[i] = face[i] == moved ? target : position[face[i]];
+      }
+
+      auto before = (position[face[1]] - position[face[0]])
+                        .cross(position[face[2]] - position[face[0]]);
+      auto after = (corners[1] - corners[0]).cross(corners[2] - corners[0]);
+
+      if (after.mag2() <= 1e-12 * before.mag2() || before.dot(after) <= 0) {
+        return false;
+      }
+    }
+
+    return true;
+  };
+
+  G4double max_error = tolerance * tolerance;
+
+  while (!queue.empty()) {
+    auto collapse = queue.top();
+    queue.pop();
+
+    if (collapse.error > max_error) {
+      break;
+    }
+
+    size_t u = collapse.u, v = collapse.v;
+
+    if (point_removed[u] || point_removed[v] ||
+        version[u] != collapse.u_version || version[v] != collapse.v_version) {
+      continue;
+    }
+
+    // The link condition: u and v may only share the two vertices opposite
+    // the edge, or the collapse pinches the surface.
+    auto u_neighbours = neighbours(u);
+    auto v_neighbours = neighbours(v);
+
+    std::vector<size_t> shared;
+    std::set_intersection(u_neighbours.begin(), u_neighbours.end(),
+                          v_neighbours.begin(), v_neighbours.end(),
+                          std::back_inserter(shared));
+
+    if (shared.size() != 2) {
+      continue;
+    }
+
+    G4ThreeVector target;
+    evaluate(u, v, target);
+
+    if (!keeps_orientation(u, v, target) || !keeps_orientation(v, u, target)) {
+      continue;
+    }
+
+    for (auto f : point_faces[v]) {
+      auto &face = faces[f];
+
+      if (face[0] == u || face[1] == u || face[2] == u) {
+        face_removed[f] = true;
+        continue;
+      }
+
+      for (auto &index : face) {
+        if (index == v) {
+          index = u;
+        }
+      }
+
+      point_faces[u].push_back(f);
+    }
+
+    point_faces[u].erase(std::remove_if(point_faces[u].begin(),
+                                        point_faces[u].end(),
+                                        [&](size_t f) { return face_removed[f]; }),
+                         point_faces[u].end());
+    point_faces[v].clear();
+
+    position[u] = target;
+    quadrics[u] = quadrics[u] + quadrics[v];
+    point_removed[v] = true;
+    version[u]++;
+    version[v]++;
+
+    for (auto w : neighbours(u)) {
+      if (!locked[w]) {
+        queue.push(make_collapse(u, w));
+      }
+    }
+  }
+
+  std::vector<size_t> new_index(n_points, 0);
+  Points points;
+
+  for (size_t i = 0; i < n_points; i++) {
+    if (!point_removed[i]) {
+      new_index[i] = points.size();
+      points.push_back(position[i]);
+    }
+  }
+
+  Indices indices;
+
+  for (size_t f = 0; f < n_faces; f++) {
+    if (!face_removed[f]) {
+      for (auto index : faces[f]) {
+        indices.push_back(new_index[index]);
+      }
+    }
+  }
+
+  return New(std::move(points), std::move(indices), name_);
 }
 }
 
@@ -701,31 +1150,75 @@ inline void Reader::SetMeshes(Meshes meshes) { meshes_ = meshes; }
 }
 }
 
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <streambuf>
 
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace CADMesh {
 
 namespace File {
 
-inline Lexer::Lexer(std::string filepath, State *initial_state) {
-  std::ifstream file(filepath);
-  input_ = std::string((std::istreambuf_iterator<char>(file)),
-                       std::istreambuf_iterator<char>());
+inline MappedFile::MappedFile(std::string filepath) {
+#if defined(__unix__) || defined(__APPLE__)
+  int file = ::open(filepath.c_str(), O_RDONLY);
+
+  if (file >= 0) {
+    struct stat info;
+
+    if (::fstat(file, &info) == 0 && info.st_size > 0) {
+      auto mapped =
+          ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+      if (mapped != MAP_FAILED) {
+        mapped_ = mapped;
+        mapped_size_ = info.st_size;
+        view_ = std::string_view((const char *)mapped_, mapped_size_);
+      }
+    }
+
+    ::close(file);
+  }
+#endif
+
+  if (!mapped_) {
+    std::ifstream file(filepath);
+    buffer_ = std::string((std::istreambuf_iterator<char>(file)),
+                          std::istreambuf_iterator<char>());
+    view_ = buffer_;
+  }
+}
+
+inline MappedFile::~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+  if (mapped_) {
+    ::munmap(mapped_, mapped_size_);
+  }
+#endif
+}
 
+inline Lexer::Lexer(std::string filepath, State *initial_state)
+    : file_(filepath), input_(file_.View()) {
   if (initial_state) {
     Run(initial_state);
   }
 }
 
 inline std::string Lexer::String() {
-  return input_.substr(start_, position_ - start_);
+  return std::string(input_.substr(start_, position_ - start_));
 }
 
 inline void Lexer::Run(State *initial_state, size_t lines) {
-  parent_item_ = new Item{ParentToken, position_,          line_, "", "",
-                          nullptr,     std::vector<Item>()};
+  roots_.emplace_back(new Item{ParentToken, position_, line_, "", "", nullptr,
+                               std::vector<Item>()});
+  parent_item_ = roots_.back().get();
 
   state_ = initial_state;
 
@@ -739,53 +1232,50 @@ inline void Lexer::Run(State *initial_state, size_t lines) {
   }
 }
 
-inline Items Lexer::GetItems() { return parent_item_->children; }
+inline const Items &Lexer::GetItems() { return parent_item_->children; }
 
 inline void Lexer::Backup() {
   position_ -= width_;
 
-  auto next = input_.substr(position_, 1);
-
-  if (next == "\n") {
+  if (input_[position_] == '\n') {
     line_--;
   }
 }
 
 inline void Lexer::BackupTo(int position) {
-  auto s = input_.substr(position, position_ - position);
-  line_ -= std::count(s.begin(), s.end(), '\n');
+  line_ -= std::count(input_.begin() + position, input_.begin() + position_,
+                      '\n');
 
   position_ = position;
 }
 
-inline std::string Lexer::Next() {
+inline char Lexer::Next() {
   if (position_ >= input_.length()) {
-    return "";
+    return '\0';
   }
 
-  auto next = input_.substr(position_, 1);
+  auto next = input_[position_];
 
   width_ = 1;
   position_ += width_;
 
-  if (next == "\n")
+  if (next == '\n')
     line_++;
 
   return next;
 }
 
-inline std::string Lexer::Peek() {
-  auto next = Next();
-
-  if (next != "")
-    Backup();
+inline char Lexer::Peek() {
+  if (position_ >= input_.length()) {
+    return '\0';
+  }
 
-  return next;
+  return input_[position_];
 }
 
 inline void Lexer::Skip() { start_ = position_; }
 
-inline Item *Lexer::ThisIsA(Token token, std::string error) {
+inline Item *Lexer::ThisIsA(const Token &token, const std::string &error) {
   if (dry_run_)
     return nullptr;
 
@@ -796,7 +1286,7 @@ inline Item *Lexer::ThisIsA(Token token, std::string error) {
   if (parent_item_) {
     PrintItem(item);
 
-    parent_item_->children.push_back(item);
+    parent_item_->children.push_back(std::move(item));
     return &(parent_item_->children.back());
   }
 
@@ -804,12 +1294,12 @@ inline Item *Lexer::ThisIsA(Token token, std::string error) {
     depth_++;
     PrintItem(item);
 
-    items_.push_back(item);
+    items_.push_back(std::move(item));
     return &(items_.back());
   }
 }
 
-inline Item *Lexer::StartOfA(Token token, std::string error) {
+inline Item *Lexer::StartOfA(const Token &token, const std::string &error) {
   if (dry_run_)
     return nullptr;
 
@@ -820,7 +1310,7 @@ inline Item *Lexer::StartOfA(Token token, std::string error) {
   return parent_item_;
 }
 
-inline Item *Lexer::EndOfA(Token token, std::string /*error*/) {
+inline Item *Lexer::EndOfA(const Token &token, const std::string & /*error*/) {
   if (dry_run_)
     return nullptr;
 
@@ -841,7 +1331,8 @@ inline Item *Lexer::EndOfA(Token token, std::string /*error*/) {
   return nullptr;
 }
 
-inline Item *Lexer::MaybeEndOfA(Token token, std::string error) {
+inline Item *Lexer::MaybeEndOfA(const Token &token,
+                                const std::string &error) {
   if (parent_item_->token.name == token.name) {
     return EndOfA(token, error);
   }
@@ -851,20 +1342,18 @@ inline Item *Lexer::MaybeEndOfA(Token token, std::string error) {
   }
 }
 
-inline bool Lexer::OneOf(std::string possibles) {
+inline bool Lexer::OneOf(std::string_view possibles) {
   auto peek = Peek();
 
-  size_t position = possibles.find(Peek());
-
-  if (position != std::string::npos) {
-    auto next = Next();
-    return next != "";
+  if (peek != '\0' && possibles.find(peek) != std::string_view::npos) {
+    Next();
+    return true;
   }
 
   return false;
 }
 
-inline bool Lexer::ManyOf(std::string possibles) {
+inline bool Lexer::ManyOf(std::string_view possibles) {
   bool has = false;
 
   while (OneOf(possibles)) {
@@ -874,23 +1363,25 @@ inline bool Lexer::ManyOf(std::string possibles) {
   return has;
 }
 
-inline bool Lexer::Until(std::string match) {
+inline bool Lexer::Until(std::string_view match) {
   while (!OneOf(match)) {
-    if (Next() == "")
+    if (Next() == '\0')
       return false;
   }
 
   return true;
 }
 
-inline bool Lexer::MatchExactly(std::string match) {
+inline bool Lexer::MatchExactly(std::string_view match) {
   auto start_position = position_;
 
   for (auto m : match) {
-    if (!OneOf(std::string(1, m))) {
+    if (Peek() != m) {
       BackupTo(start_position);
       return false;
     }
+
+    Next();
   }
 
   return true;
@@ -1070,13 +1561,13 @@ inline void Lexer::PrintMessage(std::string, std::string) {}
 #endif
 
 #ifdef CADMESH_LEXER_VERBOSE
-inline void Lexer::PrintItem(Item item) {
+inline void Lexer::PrintItem(const Item &item) {
   auto depth = std::max(0, depth_) * 2;
   std::cout << std::string(depth, ' ') << item.token.name << ": " << item.value
             << std::endl;
 }
 #else
-inline void Lexer::PrintItem(Item) {}
+inline void Lexer::PrintItem(const Item &) {}
 #endif
 }
 }
@@ -1123,6 +1614,16 @@ CADMeshTemplate<T>::CADMeshTemplate(G4String file_name, File::Type file_type,
   reader_ = reader;
 
   reader_->Read(file_name_);
+
+#ifndef CADMESH_DISABLE_MESH_CHECK
+  for (auto mesh : reader_->GetMeshes()) {
+    auto check = mesh->Check();
+
+    if (!check.IsValid()) {
+      Exceptions::InvalidMesh(file_name_, mesh->GetName(), check);
+    }
+  }
+#endif
 }
 
 template <typename T>
@@ -1213,6 +1714,11 @@ template <typename T> void CADMeshTemplate<T>::SetOffset(G4ThreeVector offset) {
 template <typename T> G4ThreeVector CADMeshTemplate<T>::GetOffset() {
   return offset_;
 }
+
+template <typename T>
+std::shared_ptr<File::Reader> CADMeshTemplate<T>::GetReader() {
+  return reader_;
+}
 }
 
 namespace CADMesh {
@@ -1261,6 +1767,19 @@ inline void MeshNotFound(G4String origin, G4String name) {
       ("CADMesh in " + origin).c_str(), "MeshNotFound", FatalException,
       ("\nThe mesh with name '" + name + "' could not be found.").c_str());
 }
+
+inline void InvalidMesh(G4String origin, G4String name,
+                        const MeshCheck &check) {
+  std::stringstream message;
+  message << "\nThe mesh '" << name << "' is not a closed surface, so "
+          << "navigation in it may fail:"
+          << "\n\t" << check.open_edges << " open edge(s)"
+          << "\n\t" << check.non_manifold_edges << " non-manifold edge(s)"
+          << "\n\t" << check.degenerate_facets << " degenerate facet(s)";
+
+  G4Exception(("CADMesh in " + origin).c_str(), "InvalidMesh", JustWarning,
+              message.str().c_str());
+}
 }
 }
 
@@ -1327,21 +1846,41 @@ inline G4TessellatedSolid *TessellatedMesh::GetTessellatedSolid(G4String name,
 
 inline G4TessellatedSolid *
 TessellatedMesh::GetTessellatedSolid(std::shared_ptr<Mesh> mesh) {
+  if (decimation_tolerance_ > 0) {
+    auto triangles = mesh->GetNumberOfTriangles();
+
+    mesh = mesh->Decimate(decimation_tolerance_ / scale_);
+
+    if (verbose_ > 0) {
+      G4cout << "CADMesh: decimated mesh '" << mesh->GetName() << "' from "
+             << triangles << " to " << mesh->GetNumberOfTriangles()
+             << " facets." << G4endl;
+    }
+  }
+
   auto volume_solid = new G4TessellatedSolid(mesh->GetName());
 
-  for (auto triangle : mesh->GetTriangles()) {
-    auto a = triangle->GetVertex(0) * scale_ + offset_;
-    auto b = triangle->GetVertex(1) * scale_ + offset_;
-    auto c = triangle->GetVertex(2) * scale_ + offset_;
+  Points points;
+  points.reserve(mesh->GetPoints().size());
+
+  for (const auto &point : mesh->GetPoints()) {
+    points.push_back(point * scale_ + offset_);
+  }
+
+  // The solid owns its facets, and these are the only ones made per mesh.
+  auto &indices = mesh->GetIndices();
 
-    auto t = new G4TriangularFacet(a, b, c, ABSOLUTE);
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    auto &a = points[indices[i]];
+    auto &b = points[indices[i + 1]];
+    auto &c = points[indices[i + 2]];
 
     if (reverse_) {
-      volume_solid->AddFacet((G4VFacet *)t->GetFlippedFacet());
+      volume_solid->AddFacet(new G4TriangularFacet(a, c, b, ABSOLUTE));
     }
 
     else {
-      volume_solid->AddFacet((G4VFacet *)t);
+      volume_solid->AddFacet(new G4TriangularFacet(a, b, c, ABSOLUTE));
     }
   }
 
@@ -1393,15 +1932,7 @@ inline G4AssemblyVolume *TetrahedralMesh::GetAssembly() {
 
   G4bool do_tet = true;
 
-  if (file_type_ == File::STL) {
-    in_->load_stl(fn);
-  }
-
-  else if (file_type_ == File::PLY) {
-    in_->load_ply(fn);
-  }
-
-  else if (file_type_ == File::TET) {
+  if (file_type_ == File::TET) {
     out_->load_tetmesh(fn, 0);
     do_tet = false;
   }
@@ -1411,18 +1942,60 @@ inline G4AssemblyVolume *TetrahedralMesh::GetAssembly() {
     do_tet = false;
   }
 
+  else {
+    // Hand TetGen the mesh our own reader already parsed, rather than have
+    // it read the file again; its loaders only know ASCII STL.
+    auto mesh = reader_->GetMesh();
+    auto &points = mesh->GetPoints();
+    auto &indices = mesh->GetIndices();
+
+    in_->firstnumber = 0;
+    in_->numberofpoints = (int)points.size();
+    in_->pointlist = new REAL[3 * points.size()];
+
+    for (size_t i = 0; i < points.size(); i++) {
+      in_->pointlist[3 * i] = points[i].x();
+      in_->pointlist[3 * i + 1] = points[i].y();
+      in_->pointlist[3 * i + 2] = points[i].z();
+    }
+
+    in_->numberoffacets = (int)mesh->GetNumberOfTriangles();
+    in_->facetlist = new tetgenio::facet[in_->numberoffacets];
+
+    for (int i = 0; i < in_->numberoffacets; i++) {
+      auto &facet = in_->facetlist[i];
+      facet.numberofpolygons = 1;
+      facet.polygonlist = new tetgenio::polygon[1];
+      facet.numberofholes = 0;
+      facet.holelist = nullptr;
+
+      auto &polygon = facet.polygonlist[0];
+      polygon.numberofvertices = 3;
+      polygon.vertexlist = new int[3];
+
+      for (int j = 0; j < 3; j++) {
+        polygon.vertexlist[j] = (int)indices[3 * i + j];
+      }
+    }
+  }
+
   if (do_tet) {
-    tetgenbehavior *behavior = new tetgenbehavior();
-    behavior->nobisect = 1;
-    behavior->plc = 1;
-    behavior->quality = quality_;
+    tetgenbehavior behavior;
+    behavior.nobisect = 1;
+    behavior.plc = 1;
+
+    // quality_ is TetGen's radius-edge ratio bound; zero leaves the
+    // tetrahedra unrefined.
+    if (quality_ > 0) {
+      behavior.quality = 1;
+      behavior.minratio = quality_;
+    }
 
-    tetrahedralize(behavior, in_.get(), out_.get());
+    tetrahedralize(&behavior, in_.get(), out_.get());
   }
 
   G4RotationMatrix *element_rotation = new G4RotationMatrix();
   G4ThreeVector element_position = G4ThreeVector();
-  G4Transform3D assembly_transform = G4Translate3D();
 
   for (int i = 0; i < out_->numberoftetrahedra; i++) {
     int index_offset = i * 4;
@@ -1449,11 +2022,11 @@ inline G4AssemblyVolume *TetrahedralMesh::GetAssembly() {
 
 inline G4ThreeVector TetrahedralMesh::GetTetPoint(G4int index_offset) {
   return G4ThreeVector(
-      out_->pointlist[out_->tetrahedronlist[index_offset] * 3] * scale_ -
+      out_->pointlist[out_->tetrahedronlist[index_offset] * 3] * scale_ +
           offset_.x(),
-      out_->pointlist[out_->tetrahedronlist[index_offset] * 3 + 1] * scale_ -
+      out_->pointlist[out_->tetrahedronlist[index_offset] * 3 + 1] * scale_ +
           offset_.y(),
-      out_->pointlist[out_->tetrahedronlist[index_offset] * 3 + 2] * scale_ -
+      out_->pointlist[out_->tetrahedronlist[index_offset] * 3 + 2] * scale_ +
           offset_.z());
 }
 }
@@ -1530,7 +2103,7 @@ inline G4ThreeVector TetrahedralMesh::GetTetPoint(G4int index_offset) {
 #define SkipLine() lexer->SkipLine()
 #define DidNotSkipLine() !SkipLine()
 
-#define AtEndOfLine() Next() == "\n" || Next() == "\r"
+#define AtEndOfLine() Next() == '\n' || Next() == '\r'
 
 #define Error(message)                                                         \
   {                                                                            \
@@ -1538,53 +2111,152 @@ inline G4ThreeVector TetrahedralMesh::GetTetPoint(G4int index_offset) {
     return nullptr;                                                            \
   }
 
-#define NextState(next) return new next##State()
-#define TestState(next) lexer->TestState(new next##State())
+#define NextState(next) return StateInstance<next##State>()
+#define TestState(next) lexer->TestState(StateInstance<next##State>())
 #define TryState(next)                                                         \
   if (TestState(next))                                                         \
   NextState(next)
-#define FinalState() return new __FinalState();
+#define FinalState() return StateInstance<__FinalState>();
 
-#define RunLexer(filepath, start) Lexer(filepath, new start##State).GetItems()
+#include <charconv>
+#include <thread>
+
+// Text meshes at least this big are parsed on several threads, see
+// ParseInParallel. Smaller ones (and anything the fast path doesn't
+// understand) go through the lexer, which gives better error messages.
+#ifndef CADMESH_PARALLEL_PARSE_MIN_BYTES
+#define CADMESH_PARALLEL_PARSE_MIN_BYTES (1 << 20)
+#endif
 
 namespace CADMesh {
 
 namespace File {
 
-class STLReader : public Reader {
-public:
-  STLReader() : Reader("STLReader"){};
+// Splits input into one piece per hardware thread, each ending just after an
+// occurrence of boundary, and runs parse on each piece on its own thread.
+// The results come back in file order, whichever thread finishes first.
+template <typename Result, typename Parse>
+std::vector<Result> ParseInParallel(std::string_view input,
+                                    std::string_view boundary, Parse parse) {
+  size_t pieces = std::max(1u, std::thread::hardware_concurrency());
+  pieces = std::max<size_t>(1, std::min(pieces, input.size() / (1 << 16)));
 
-  G4bool Read(G4String filepath);
-  G4bool CanRead(Type file_type);
+  std::vector<size_t> cuts{0};
 
-protected:
-  CADMeshLexerStateDefinition(StartSolid);
-  CADMeshLexerStateDefinition(EndSolid);
+  for (size_t i = 1; i < pieces; i++) {
+    auto cut = input.find(boundary, std::max(cuts.back(), i * input.size() /
+                                                              pieces));
 
-  CADMeshLexerStateDefinition(StartFacet);
-  CADMeshLexerStateDefinition(EndFacet);
+    if (cut == std::string_view::npos)
+      break;
 
-  CADMeshLexerStateDefinition(StartVertices);
-  CADMeshLexerStateDefinition(EndVertices);
+    cuts.push_back(cut + boundary.size());
+  }
 
-  CADMeshLexerStateDefinition(Vertex);
+  cuts.push_back(input.size());
 
-  CADMeshLexerStateDefinition(ThreeVector);
+  std::vector<Result> results(cuts.size() - 1);
+  std::vector<std::thread> threads;
 
-  std::shared_ptr<Mesh> ParseMesh(Items items);
-  G4TriangularFacet *ParseFacet(Items items);
-  G4TriangularFacet *ParseVertices(Items items);
-  G4ThreeVector ParseThreeVector(Items items);
-};
-}
-}
+  for (size_t i = 1; i < results.size(); i++) {
+    threads.emplace_back([&, i]() {
+      results[i] = parse(input.substr(cuts[i], cuts[i + 1] - cuts[i]));
+    });
+  }
 
-namespace CADMesh {
+  results[0] = parse(input.substr(0, cuts[1]));
 
-namespace File {
+  for (auto &thread : threads) {
+    thread.join();
+  }
 
-class OBJReader : public Reader {
+  return results;
+}
+
+// Returns the next whitespace separated word on the current line, moving
+// position past it; empty at the end of the line (or of the text).
+inline std::string_view NextWord(std::string_view text, size_t &position) {
+  while (position < text.size() &&
+         (text[position] == ' ' || text[position] == '\t' ||
+          text[position] == '\r')) {
+    position++;
+  }
+
+  auto start = position;
+
+  while (position < text.size() && !std::isspace((unsigned char)text[position])) {
+    position++;
+  }
+
+  return text.substr(start, position - start);
+}
+
+// Moves position to the start of the next line.
+inline void SkipToNextLine(std::string_view text, size_t &position) {
+  position = std::min(text.find('\n', position), text.size());
+
+  if (position < text.size()) {
+    position++;
+  }
+}
+
+template <typename T> bool ParseNumber(std::string_view word, T &value) {
+  if (!word.empty() && word[0] == '+') {
+    word.remove_prefix(1);
+  }
+
+  auto end = word.data() + word.size();
+  auto result = std::from_chars(word.data(), end, value);
+
+  return result.ec == std::errc() && result.ptr == end;
+}
+
+class STLReader : public Reader {
+public:
+  STLReader() : Reader("STLReader"){};
+
+  G4bool Read(G4String filepath);
+  G4bool CanRead(Type file_type);
+
+protected:
+  CADMeshLexerStateDefinition(StartSolid);
+  CADMeshLexerStateDefinition(EndSolid);
+
+  CADMeshLexerStateDefinition(StartFacet);
+  CADMeshLexerStateDefinition(EndFacet);
+
+  CADMeshLexerStateDefinition(StartVertices);
+  CADMeshLexerStateDefinition(EndVertices);
+
+  CADMeshLexerStateDefinition(Vertex);
+
+  CADMeshLexerStateDefinition(ThreeVector);
+
+  std::shared_ptr<Mesh> ParseMesh(const Items &items);
+  void ParseFacet(const Items &items, Points &corners);
+  void ParseVertices(const Items &items, Points &corners);
+  G4ThreeVector ParseThreeVector(const Items &items);
+
+  // Binary STL: an 80 byte header, a uint32 triangle count, then 50 bytes per
+  // triangle (normal, three vertices as float32 and a uint16 attribute).
+  // Many exporters also start the header with "solid", so the file size is
+  // what tells the two formats apart.
+  static G4bool IsBinary(G4String filepath);
+  G4bool ReadBinary(G4String filepath);
+
+  // Parses large single-solid ASCII files a range of facets per thread.
+  // Returns false, without reading anything, if the file should go through
+  // the lexer instead.
+  G4bool ReadParallel(G4String filepath);
+};
+}
+}
+
+namespace CADMesh {
+
+namespace File {
+
+class OBJReader : public Reader {
 public:
   OBJReader() : Reader("OBJReader"){};
 
@@ -1600,9 +2272,14 @@ protected:
   CADMeshLexerStateDefinition(Facet);
   CADMeshLexerStateDefinition(Object);
 
-  std::shared_ptr<Mesh> ParseMesh(Items items);
-  G4ThreeVector ParseVertex(Items items);
-  G4TriangularFacet *ParseFacet(Items items, G4bool quad);
+  std::shared_ptr<Mesh> ParseMesh(const Items &items);
+  G4ThreeVector ParseVertex(const Items &items);
+  // Splits the facet into a fan of triangles around its first vertex.
+  void ParseFacet(const Items &items, Points &corners);
+
+  // Parses large files a range of lines per thread. Returns false, without
+  // reading anything, if the file should go through the lexer instead.
+  G4bool ReadParallel(G4String filepath);
 
 private:
   Points vertices_;
@@ -1636,11 +2313,11 @@ protected:
   CADMeshLexerStateDefinition(Vertex);
   CADMeshLexerStateDefinition(Facet);
 
-  void ParseHeader(Items items);
+  void ParseHeader(const Items &items);
 
-  std::shared_ptr<Mesh> ParseMesh(Items vertex_items, Items face_items);
-  G4ThreeVector ParseVertex(Items items);
-  G4TriangularFacet *ParseFacet(Items items, Points vertices);
+  std::shared_ptr<Mesh> ParseMesh(const Items &vertex_items, const Items &face_items);
+  G4ThreeVector ParseVertex(const Items &items);
+  void ParseFacet(const Items &items, Indices &indices);
 
   size_t vertex_count_ = 0;
   size_t facet_count_ = 0;
@@ -1803,14 +2480,23 @@ inline State *STLReader::CADMeshLexerState(ThreeVector) {
 }
 
 inline G4bool STLReader::Read(G4String filepath) {
-  auto items = RunLexer(filepath, StartSolid);
+  if (IsBinary(filepath)) {
+    return ReadBinary(filepath);
+  }
+
+  if (ReadParallel(filepath)) {
+    return true;
+  }
+
+  Lexer lexer(filepath, StateInstance<StartSolidState>());
+  auto &items = lexer.GetItems();
 
   if (items.size() == 0) {
     Exceptions::ParserError("STLReader::Read",
                             "The STL file appears to be empty.");
   }
 
-  for (auto item : items) {
+  for (const auto &item : items) {
     if (item.children.size() == 0) {
       std::stringstream error;
       error << "The mesh appears to be empty."
@@ -1830,10 +2516,172 @@ inline G4bool STLReader::Read(G4String filepath) {
 
 inline G4bool STLReader::CanRead(Type file_type) { return (file_type == STL); }
 
-inline std::shared_ptr<Mesh> STLReader::ParseMesh(Items items) {
-  Triangles triangles;
+inline G4bool STLReader::IsBinary(G4String filepath) {
+  std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+
+  if (!file.good()) {
+    return false;
+  }
+
+  std::streamoff size = file.tellg();
+
+  if (size < 84) {
+    return false;
+  }
+
+  unsigned char count[4];
+  file.seekg(80);
+  file.read(reinterpret_cast<char *>(count), 4);
+
+  std::streamoff triangles = (std::streamoff)count[0] |
+                             (std::streamoff)count[1] << 8 |
+                             (std::streamoff)count[2] << 16 |
+                             (std::streamoff)count[3] << 24;
+
+  return file.good() && size == 84 + 50 * triangles;
+}
+
+inline G4bool STLReader::ReadBinary(G4String filepath) {
+  std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+
+  if (!file.good()) {
+    Exceptions::FileNotFound("STLReader::ReadBinary", filepath);
+  }
+
+  // The whole file in one read; IsBinary() already checked the size.
+  std::vector<char> buffer((size_t)file.tellg());
+  file.seekg(0);
+  file.read(buffer.data(), buffer.size());
+
+  if (!file.good()) {
+    Exceptions::ParserError("STLReader::ReadBinary",
+                            "Could not read the binary STL file.");
+  }
+
+  size_t count = (buffer.size() - 84) / 50;
+
+  if (count == 0) {
+    Exceptions::ParserError("STLReader::ReadBinary",
+                            "The STL file appears to be empty.");
+  }
+
+  Points points;
+  points.reserve(3 * count);
+
+  // Values are little-endian float32, like every machine we run on.
+  float coordinates[9];
+
+  for (size_t i = 0; i < count; i++) {
+    // Skip the 12 byte normal, which G4TriangularFacet works out itself.
+    std::memcpy(coordinates, buffer.data() + 84 + 50 * i + 12,
+                sizeof(coordinates));
+
+    for (size_t j = 0; j < 3; j++) {
+      points.push_back(G4ThreeVector(coordinates[3 * j],
+                                     coordinates[3 * j + 1],
+                                     coordinates[3 * j + 2]));
+    }
+  }
+
+  // The header is free text, and often just padding, so don't use it as
+  // the mesh name.
+  AddMesh(Mesh::FromCorners(points));
+
+  return true;
+}
+
+inline G4bool STLReader::ReadParallel(G4String filepath) {
+  MappedFile file(filepath);
+  auto input = file.View();
+
+  if (input.size() < CADMESH_PARALLEL_PARSE_MIN_BYTES ||
+      input.substr(0, 5) != "solid") {
+    return false;
+  }
+
+  // Files with more than one solid are left to the lexer.
+  auto end = input.find("endsolid");
+
+  if (end == std::string_view::npos || input.rfind("endsolid") != end) {
+    return false;
+  }
+
+  auto header_end = std::min(input.find_first_of("\n\r"), end);
+  auto name_start = std::min(input.find_first_not_of(" \t\r", 5), header_end);
+  auto name = input.substr(name_start, header_end - name_start);
+  auto body = input.substr(header_end, end - header_end);
+
+  struct Piece {
+    Points points;
+    size_t facets = 0;
+    bool valid = true;
+  };
+
+  auto pieces = ParseInParallel<Piece>(body, "endfacet", [](std::string_view
+                                                                text) {
+    Piece piece;
+    size_t position = 0;
+    G4double xyz[3];
+
+    while (position < text.size()) {
+      auto word = NextWord(text, position);
+
+      if (word.empty()) {
+        SkipToNextLine(text, position);
+      } else if (word == "facet") {
+        piece.facets++;
+        // The normal is worked out again by G4TriangularFacet.
+        SkipToNextLine(text, position);
+      } else if (word == "vertex") {
+        for (auto &value : xyz) {
+          if (!ParseNumber(NextWord(text, position), value)) {
+            piece.valid = false;
+            return piece;
+          }
+        }
+
+        piece.points.push_back(G4ThreeVector(xyz[0], xyz[1], xyz[2]));
+      } else if (word != "outer" && word != "loop" && word != "endloop" &&
+                 word != "endfacet") {
+        piece.valid = false;
+        return piece;
+      }
+    }
+
+    piece.valid = piece.valid && piece.points.size() == 3 * piece.facets;
+    return piece;
+  });
+
+  size_t count = 0;
+
+  for (const auto &piece : pieces) {
+    if (!piece.valid) {
+      return false;
+    }
+
+    count += piece.points.size();
+  }
+
+  if (count == 0) {
+    return false;
+  }
+
+  Points points;
+  points.reserve(count);
+
+  for (const auto &piece : pieces) {
+    points.insert(points.end(), piece.points.begin(), piece.points.end());
+  }
+
+  AddMesh(Mesh::FromCorners(points, G4String(std::string(name))));
 
-  for (auto item : items) {
+  return true;
+}
+
+inline std::shared_ptr<Mesh> STLReader::ParseMesh(const Items &items) {
+  Points corners;
+
+  for (const auto &item : items) {
     if (item.children.size() == 0) {
       std::stringstream error;
       error << "The facet appears to be empty."
@@ -1842,16 +2690,16 @@ inline std::shared_ptr<Mesh> STLReader::ParseMesh(Items items) {
       Exceptions::ParserError("STLReader::Mesh", error.str());
     }
 
-    triangles.push_back(ParseFacet(item.children));
+    ParseFacet(item.children, corners);
   }
 
-  return Mesh::New(triangles);
+  return Mesh::FromCorners(corners);
 }
 
-inline G4TriangularFacet *STLReader::ParseFacet(Items items) {
-  Triangles triangles;
+inline void STLReader::ParseFacet(const Items &items, Points &corners) {
+  size_t triangles = 0;
 
-  for (auto item : items) {
+  for (const auto &item : items) {
     if (item.children.size() == 0) {
       std::stringstream error;
       error << "The vertex appears to be empty."
@@ -1860,10 +2708,11 @@ inline G4TriangularFacet *STLReader::ParseFacet(Items items) {
       Exceptions::ParserError("STLReader::ParseFacet", error.str());
     }
 
-    triangles.push_back(ParseVertices(item.children));
+    ParseVertices(item.children, corners);
+    triangles++;
   }
 
-  if (triangles.size() != 1) {
+  if (triangles != 1) {
     std::stringstream error;
     error << "STL files expect exactly 1 triangle per facet.";
 
@@ -1873,14 +2722,12 @@ inline G4TriangularFacet *STLReader::ParseFacet(Items items) {
 
     Exceptions::ParserError("STLReader::ParseFacet", error.str());
   }
-
-  return triangles[0];
 }
 
-inline G4TriangularFacet *STLReader::ParseVertices(Items items) {
+inline void STLReader::ParseVertices(const Items &items, Points &corners) {
   std::vector<G4ThreeVector> vertices;
 
-  for (auto item : items) {
+  for (const auto &item : items) {
     if (item.children.size() == 0) {
       std::stringstream error;
       error << "The vertex appears to be empty."
@@ -1903,13 +2750,13 @@ inline G4TriangularFacet *STLReader::ParseVertices(Items items) {
     Exceptions::ParserError("STLReader::ParseVertices", error.str());
   }
 
-  return new G4TriangularFacet(vertices[0], vertices[1], vertices[2], ABSOLUTE);
+  corners.insert(corners.end(), vertices.begin(), vertices.end());
 }
 
-inline G4ThreeVector STLReader::ParseThreeVector(Items items) {
+inline G4ThreeVector STLReader::ParseThreeVector(const Items &items) {
   std::vector<double> numbers;
 
-  for (auto item : items) {
+  for (const auto &item : items) {
     numbers.push_back((double)atof(item.value.c_str()));
   }
 
@@ -1944,7 +2791,7 @@ inline State *OBJReader::CADMeshLexerState(StartSolid) {
 }
 
 inline State *OBJReader::CADMeshLexerState(EndSolid) {
-  if (Next() != "")
+  if (Next() != '\0')
     lexer->LastError();
 
   EndOfA(Solid);
@@ -2043,9 +2890,17 @@ inline State *OBJReader::CADMeshLexerState(Facet) {
   Number();
   SkipWhiteSpace();
 
-  if (Number())
+  // Quads and larger polygons.
+  while (Number()) {
     ThisIsA(Number);
 
+    OneOf("/");
+    Number();
+    OneOf("/");
+    Number();
+    SkipWhiteSpace();
+  }
+
   EndOfA(Facet);
 
   SkipLine();
@@ -2082,21 +2937,26 @@ inline State *OBJReader::CADMeshLexerState(Object) {
 }
 
 inline G4bool OBJReader::Read(G4String filepath) {
-  auto items = RunLexer(filepath, StartSolid);
+  if (ReadParallel(filepath)) {
+    return true;
+  }
+
+  Lexer lexer(filepath, StateInstance<StartSolidState>());
+  auto &items = lexer.GetItems();
 
   if (items.size() == 0) {
     Exceptions::ParserError("OBJReader::Read",
                             "The OBJ file appears to be empty.");
   }
 
-  for (auto item : items) {
+  for (const auto &item : items) {
     if (item.children.size() == 0) {
       continue;
     }
 
     auto mesh = ParseMesh(item.children);
 
-    if (mesh->GetTriangles().size() == 0) {
+    if (mesh->GetNumberOfTriangles() == 0) {
       continue;
     }
 
@@ -2114,52 +2974,180 @@ inline G4bool OBJReader::Read(G4String filepath) {
 
 inline G4bool OBJReader::CanRead(Type file_type) { return (file_type == OBJ); }
 
-inline std::shared_ptr<Mesh> OBJReader::ParseMesh(Items items) {
-  Triangles facets;
+inline G4bool OBJReader::ReadParallel(G4String filepath) {
+  MappedFile file(filepath);
+  auto input = file.View();
 
-  for (auto item : items) {
-    if (item.token != VertexToken) {
-      continue;
+  if (input.size() < CADMESH_PARALLEL_PARSE_MIN_BYTES) {
+    return false;
+  }
+
+  // Facet indices are into the vertices of the whole file, and objects can
+  // span pieces, so each piece keeps the facets it saw before its first 'o'
+  // line separately (objects[0]), to be added to the previous piece's last
+  // object.
+  struct Object {
+    std::string name;
+    std::vector<long> indices;
+  };
+
+  struct Piece {
+    Points vertices;
+    std::vector<Object> objects{Object()};
+    bool valid = true;
+  };
+
+  auto pieces = ParseInParallel<Piece>(input, "\n", [](std::string_view text) {
+    Piece piece;
+    size_t position = 0;
+    G4double xyz[3];
+    long facet[4];
+
+    while (position < text.size()) {
+      auto tag = NextWord(text, position);
+
+      if (tag == "v") {
+        for (auto &value : xyz) {
+          if (!ParseNumber(NextWord(text, position), value)) {
+            piece.valid = false;
+            return piece;
+          }
+        }
+
+        piece.vertices.push_back(G4ThreeVector(xyz[0], xyz[1], xyz[2]));
+      } else if (tag == "f") {
+        size_t n = 0;
+
+        for (; n < 4; n++) {
+          auto word = NextWord(text, position);
+
+          if (word.empty())
+            break;
+
+          // Only the vertex index of "v/vt/vn" is used. Relative
+          // (negative) indices are left to the lexer.
+          if (!ParseNumber(word.substr(0, word.find('/')), facet[n]) ||
+              facet[n] < 1) {
+            piece.valid = false;
+            return piece;
+          }
+        }
+
+        // Faces with more than four vertices are left to the lexer too.
+        if (n < 3 || (n == 4 && !NextWord(text, position).empty())) {
+          piece.valid = false;
+          return piece;
+        }
+
+        auto &indices = piece.objects.back().indices;
+        indices.insert(indices.end(), {facet[0], facet[1], facet[2]});
+
+        if (n == 4) {
+          indices.insert(indices.end(), {facet[0], facet[2], facet[3]});
+        }
+      } else if (tag == "o") {
+        piece.objects.push_back(Object{std::string(NextWord(text, position)),
+                                       std::vector<long>()});
+      }
+
+      SkipToNextLine(text, position);
     }
 
-    if (item.children.size() == 0) {
-      std::stringstream error;
-      error << "The vertex appears to be empty."
-            << "Error around line " << item.line << ".";
+    return piece;
+  });
 
-      Exceptions::ParserError("OBJReader::Mesh", error.str());
+  // Nothing is kept unless every piece parsed, since the lexer starts over
+  // from the beginning of the file.
+  for (const auto &piece : pieces) {
+    if (!piece.valid) {
+      return false;
     }
+  }
+
+  Points vertices;
+  std::vector<Object> objects{Object()};
+
+  for (auto &piece : pieces) {
+    vertices.insert(vertices.end(), piece.vertices.begin(),
+                    piece.vertices.end());
 
-    vertices_.push_back(ParseVertex(item.children));
+    auto &indices = objects.back().indices;
+    indices.insert(indices.end(), piece.objects[0].indices.begin(),
+                   piece.objects[0].indices.end());
+
+    objects.insert(objects.end(),
+                   std::make_move_iterator(piece.objects.begin() + 1),
+                   std::make_move_iterator(piece.objects.end()));
   }
 
-  for (auto item : items) {
-    if (item.token != FacetToken) {
+  for (const auto &object : objects) {
+    if (object.indices.size() == 0) {
       continue;
     }
 
-    if (item.children.size() == 0) {
-      std::stringstream error;
-      error << "The facet appears to be empty."
-            << "Error around line " << item.line << ".";
+    for (auto index : object.indices) {
+      if (index > (long)vertices.size()) {
+        std::stringstream error;
+        error << "Facet vertex index " << index << " is out of range.";
+
+        Exceptions::ParserError("OBJReader::ReadParallel", error.str());
+      }
+    }
+
+    Points corners;
+    corners.reserve(object.indices.size());
+
+    for (auto index : object.indices) {
+      corners.push_back(vertices[index - 1]);
+    }
+
+    // Re-index, so each mesh only holds the vertices it uses.
+    AddMesh(Mesh::FromCorners(corners, object.name));
+  }
+
+  vertices_.insert(vertices_.end(), vertices.begin(), vertices.end());
+
+  return true;
+}
+
+inline std::shared_ptr<Mesh> OBJReader::ParseMesh(const Items &items) {
+  Points corners;
 
-      Exceptions::ParserError("OBJReader::Mesh", error.str());
+  // One pass in file order, so that relative (negative) facet indices count
+  // back from the vertices read so far.
+  for (const auto &item : items) {
+    if (item.token == VertexToken) {
+      if (item.children.size() == 0) {
+        std::stringstream error;
+        error << "The vertex appears to be empty."
+              << "Error around line " << item.line << ".";
+
+        Exceptions::ParserError("OBJReader::Mesh", error.str());
+      }
+
+      vertices_.push_back(ParseVertex(item.children));
     }
 
-    facets.push_back(ParseFacet(item.children, false));
+    else if (item.token == FacetToken) {
+      if (item.children.size() == 0) {
+        std::stringstream error;
+        error << "The facet appears to be empty."
+              << "Error around line " << item.line << ".";
+
+        Exceptions::ParserError("OBJReader::Mesh", error.str());
+      }
 
-    if (item.children.size() == 4) {
-      facets.push_back(ParseFacet(item.children, true));
+      ParseFacet(item.children, corners);
     }
   }
 
-  return Mesh::New(facets);
+  return Mesh::FromCorners(corners);
 }
 
-inline G4ThreeVector OBJReader::ParseVertex(Items items) {
+inline G4ThreeVector OBJReader::ParseVertex(const Items &items) {
   std::vector<double> numbers;
 
-  for (auto item : items) {
+  for (const auto &item : items) {
     numbers.push_back((double)atof(item.value.c_str()));
   }
 
@@ -2177,27 +3165,30 @@ inline G4ThreeVector OBJReader::ParseVertex(Items items) {
   return G4ThreeVector(numbers[0], numbers[1], numbers[2]);
 }
 
-inline G4TriangularFacet *OBJReader::ParseFacet(Items items, G4bool quad) {
+inline void OBJReader::ParseFacet(const Items &items, Points &corners) {
   std::vector<int> indices;
 
-  for (auto item : items) {
-    indices.push_back((int)atoi(item.value.c_str()));
-  }
+  for (const auto &item : items) {
+    auto index = (int)atoi(item.value.c_str());
 
-  if (indices.size() < 3) {
-    std::stringstream error;
-    error << "Facets in OBJ files require at least 3 indicies";
+    if (index < 0) {
+      index += (int)vertices_.size() + 1;
+    }
 
-    if (items.size() != 0) {
-      error << "Error around line " << items[0].line << ".";
+    if (index < 1 || index > (int)vertices_.size()) {
+      std::stringstream error;
+      error << "Facet vertex index " << item.value << " is out of range. "
+            << "Error around line " << item.line << ".";
+
+      Exceptions::ParserError("OBJReader::ParseFacet", error.str());
     }
 
-    Exceptions::ParserError("OBJReader::ParseFacet", error.str());
+    indices.push_back(index);
   }
 
-  if (quad && indices.size() != 4) {
+  if (indices.size() < 3) {
     std::stringstream error;
-    error << "Trying to triangle-ify a facet that isn't a quad";
+    error << "Facets in OBJ files require at least 3 indicies";
 
     if (items.size() != 0) {
       error << "Error around line " << items[0].line << ".";
@@ -2206,16 +3197,10 @@ inline G4TriangularFacet *OBJReader::ParseFacet(Items items, G4bool quad) {
     Exceptions::ParserError("OBJReader::ParseFacet", error.str());
   }
 
-  if (quad) {
-    return new G4TriangularFacet(vertices_[indices[0] - 1],
-                                 vertices_[indices[2] - 1],
-                                 vertices_[indices[3] - 1], ABSOLUTE);
-  }
-
-  else {
-    return new G4TriangularFacet(vertices_[indices[0] - 1],
-                                 vertices_[indices[1] - 1],
-                                 vertices_[indices[2] - 1], ABSOLUTE);
+  for (size_t i = 1; i + 1 < indices.size(); i++) {
+    corners.insert(corners.end(),
+                   {vertices_[indices[0] - 1], vertices_[indices[i] - 1],
+                    vertices_[indices[i + 1] - 1]});
   }
 }
 }
@@ -2382,8 +3367,8 @@ inline State *PLYReader::CADMeshLexerState(Facet) {
 }
 
 inline G4bool PLYReader::Read(G4String filepath) {
-  auto lexer = Lexer(filepath, new StartHeaderState);
-  auto items = lexer.GetItems();
+  auto lexer = Lexer(filepath, StateInstance<StartHeaderState>());
+  auto &items = lexer.GetItems();
 
   if (items.size() == 0) {
     std::stringstream error;
@@ -2394,8 +3379,8 @@ inline G4bool PLYReader::Read(G4String filepath) {
 
   ParseHeader(items);
 
-  lexer.Run(new VertexState, vertex_count_);
-  auto vertex_items = lexer.GetItems();
+  lexer.Run(StateInstance<VertexState>(), vertex_count_);
+  auto &vertex_items = lexer.GetItems();
 
   if (vertex_items.size() == 0) {
     Exceptions::ParserError("PLYReader::Read",
@@ -2407,8 +3392,8 @@ inline G4bool PLYReader::Read(G4String filepath) {
                             "The PLY file appears to be missing vertices.");
   }
 
-  lexer.Run(new FacetState, facet_count_);
-  auto face_items = lexer.GetItems();
+  lexer.Run(StateInstance<FacetState>(), facet_count_);
+  auto &face_items = lexer.GetItems();
 
   if (face_items.size() == 0) {
     Exceptions::ParserError("PLYReader::Read",
@@ -2428,7 +3413,7 @@ inline G4bool PLYReader::Read(G4String filepath) {
 
 inline G4bool PLYReader::CanRead(Type file_type) { return (file_type == PLY); }
 
-inline void PLYReader::ParseHeader(Items items) {
+inline void PLYReader::ParseHeader(const Items &items) {
   if (items.size() != 1) {
     std::stringstream error;
     error << "The header appears to be invalid or missing."
@@ -2437,7 +3422,7 @@ inline void PLYReader::ParseHeader(Items items) {
     Exceptions::ParserError("PLYReader::ParseHeader", error.str());
   }
 
-  for (auto item : items[0].children) {
+  for (const auto &item : items[0].children) {
     if (item.token == ElementToken) {
       if (item.children.size() < 2) {
         std::stringstream error;
@@ -2516,12 +3501,12 @@ inline void PLYReader::ParseHeader(Items items) {
   }
 }
 
-inline std::shared_ptr<Mesh> PLYReader::ParseMesh(Items vertex_items,
-                                                  Items face_items) {
+inline std::shared_ptr<Mesh> PLYReader::ParseMesh(const Items &vertex_items,
+                                                  const Items &face_items) {
   Points vertices;
-  Triangles facets;
+  Indices indices;
 
-  for (auto item : vertex_items) {
+  for (const auto &item : vertex_items) {
     if (item.children.size() == 0) {
       std::stringstream error;
       error << "The vertex appears to be empty."
@@ -2535,7 +3520,7 @@ inline std::shared_ptr<Mesh> PLYReader::ParseMesh(Items vertex_items,
     }
   }
 
-  for (auto item : face_items) {
+  for (const auto &item : face_items) {
     if (item.children.size() == 0) {
       std::stringstream error;
       error << "The facet appears to be empty."
@@ -2545,17 +3530,26 @@ inline std::shared_ptr<Mesh> PLYReader::ParseMesh(Items vertex_items,
     }
 
     if (item.token == FacetToken) {
-      facets.push_back(ParseFacet(item.children, vertices));
+      ParseFacet(item.children, indices);
     }
   }
 
-  return Mesh::New(facets);
+  for (auto index : indices) {
+    if (index >= vertices.size()) {
+      std::stringstream error;
+      error << "Facet vertex index " << index << " is out of range.";
+
+      Exceptions::ParserError("PLYReader::ParseMesh", error.str());
+    }
+  }
+
+  return Mesh::New(vertices, indices);
 }
 
-inline G4ThreeVector PLYReader::ParseVertex(Items items) {
+inline G4ThreeVector PLYReader::ParseVertex(const Items &items) {
   std::vector<double> numbers;
 
-  for (auto item : items) {
+  for (const auto &item : items) {
     numbers.push_back((double)atof(item.value.c_str()));
   }
 
@@ -2573,14 +3567,14 @@ inline G4ThreeVector PLYReader::ParseVertex(Items items) {
   return G4ThreeVector(numbers[x_index_], numbers[y_index_], numbers[z_index_]);
 }
 
-inline G4TriangularFacet *PLYReader::ParseFacet(Items items, Points vertices) {
-  std::vector<int> indices;
+inline void PLYReader::ParseFacet(const Items &items, Indices &indices) {
+  std::vector<int> values;
 
-  for (auto item : items) {
-    indices.push_back((int)atoi(item.value.c_str()));
+  for (const auto &item : items) {
+    values.push_back((int)atoi(item.value.c_str()));
   }
 
-  if (indices.size() < 4) {
+  if (values.size() < 4) {
     std::stringstream error;
     error << "Facets in PLY files require 3 indicies";
 
@@ -2591,9 +3585,22 @@ inline G4TriangularFacet *PLYReader::ParseFacet(Items items, Points vertices) {
     Exceptions::ParserError("PLYReader::ParseFacet", error.str());
   }
 
-  return new G4TriangularFacet(vertices[indices[1 + facet_index_]],
-                               vertices[indices[2 + facet_index_]],
-                               vertices[indices[3 + facet_index_]], ABSOLUTE);
+  for (size_t i = 1; i < 4; i++) {
+    if (values[i + facet_index_] < 0) {
+      std::stringstream error;
+      error << "Negative facet vertex index";
+
+      if (items.size() != 0) {
+        error << " around line " << items[0].line;
+      }
+
+      error << ".";
+
+      Exceptions::ParserError("PLYReader::ParseFacet", error.str());
+    }
+
+    indices.push_back((size_t)values[i + facet_index_]);
+  }
 }
 }
 }
@@ -2625,27 +3632,27 @@ inline G4bool ASSIMPReader::Read(G4String filepath) {
     aiMesh *mesh = scene->mMeshes[index];
     auto name = mesh->mName.C_Str();
 
-    Triangles triangles;
-
-    for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-      const aiFace &face = mesh->mFaces[i];
+    // aiProcess_JoinIdenticalVertices has already indexed the mesh.
+    Points points;
+    points.reserve(mesh->mNumVertices);
 
-      G4ThreeVector a(mesh->mVertices[face.mIndices[0]].x,
-                      mesh->mVertices[face.mIndices[0]].y,
-                      mesh->mVertices[face.mIndices[0]].z);
+    for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+      points.push_back(G4ThreeVector(mesh->mVertices[i].x,
+                                     mesh->mVertices[i].y,
+                                     mesh->mVertices[i].z));
+    }
 
-      G4ThreeVector b(mesh->mVertices[face.mIndices[1]].x,
-                      mesh->mVertices[face.mIndices[1]].y,
-                      mesh->mVertices[face.mIndices[1]].z);
+    Indices indices;
+    indices.reserve(3 * mesh->mNumFaces);
 
-      G4ThreeVector c(mesh->mVertices[face.mIndices[2]].x,
-                      mesh->mVertices[face.mIndices[2]].y,
-                      mesh->mVertices[face.mIndices[2]].z);
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
+      const aiFace &face = mesh->mFaces[i];
 
-      triangles.push_back(new G4TriangularFacet(a, b, c, ABSOLUTE));
+      indices.insert(indices.end(),
+                     {face.mIndices[0], face.mIndices[1], face.mIndices[2]});
     }
 
-    AddMesh(Mesh::New(triangles, name));
+    AddMesh(Mesh::New(points, indices, name));
   }
 
   return true;
@@ -2660,11 +3667,207 @@ std::shared_ptr<ASSIMPReader> ASSIMP() {
 }
 #endif
 
+#ifndef CADMESH_DISABLE_MESH_CACHE
+
+#include <cstdint>
+#include <cstdio>
+
+// Meshes read by the BuiltInReader are cached next to the source file, as
+// <file>.cmc, so the next run (or the next process of a sweep) can skip the
+// parsing. The cache stores each mesh as a deduplicated vertex array and
+// triangle indices, in native byte order:
+//
+//   "CADMESHC" u32 version u32 mesh count u64 FNV-1a hash of the source
+//   per mesh: u64 vertex count, u64 triangle count, u64 name length, name
+//             (padded to 8 bytes), f64 x/y/z per vertex, u32 a/b/c per
+//             triangle (padded to 8 bytes)
+//
+// The hash is of the source file contents, so an edited mesh is parsed (and
+// cached) again. Scale and offset are applied later, by TessellatedMesh, so
+// they are not part of the cache. Define CADMESH_DISABLE_MESH_CACHE to turn
+// the cache off.
+
+namespace CADMesh {
+
+namespace File {
+
+static const char MeshCacheMagic[8] = {'C', 'A', 'D', 'M', 'E', 'S', 'H', 'C'};
+static const uint32_t MeshCacheVersion = 1;
+
+inline uint64_t HashContents(std::string_view contents) {
+  uint64_t hash = 14695981039346656037ull;
+
+  for (unsigned char c : contents) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+
+  return hash;
+}
+
+inline G4String MeshCachePath(G4String filepath) { return filepath + ".cmc"; }
+
+inline G4bool ReadMeshCache(G4String filepath, uint64_t hash, Meshes &meshes) {
+  MappedFile file(MeshCachePath(filepath));
+  auto cache = file.View();
+
+  size_t position = 0;
+
+  // Returns a pointer to the next size bytes (padded to 8), or nullptr if the
+  // cache is too short.
+  auto take = [&](size_t size) -> const char * {
+    auto padded = (size + 7) / 8 * 8;
+
+    if (cache.size() - position < padded) {
+      return nullptr;
+    }
+
+    auto data = cache.data() + position;
+    position += padded;
+
+    return data;
+  };
+
+  auto header = take(24);
+
+  if (!header || std::memcmp(header, MeshCacheMagic, 8) != 0) {
+    return false;
+  }
+
+  uint32_t version, count;
+  uint64_t cached_hash;
+  std::memcpy(&version, header + 8, 4);
+  std::memcpy(&count, header + 12, 4);
+  std::memcpy(&cached_hash, header + 16, 8);
+
+  if (version != MeshCacheVersion || cached_hash != hash) {
+    return false;
+  }
+
+  for (uint32_t m = 0; m < count; m++) {
+    auto sizes = take(24);
+
+    if (!sizes) {
+      return false;
+    }
+
+    uint64_t vertex_count, triangle_count, name_size;
+    std::memcpy(&vertex_count, sizes, 8);
+    std::memcpy(&triangle_count, sizes + 8, 8);
+    std::memcpy(&name_size, sizes + 16, 8);
+
+    auto name = take(name_size);
+    auto coordinates = take(vertex_count * 3 * sizeof(G4double));
+    auto indices = take(triangle_count * 3 * sizeof(uint32_t));
+
+    if (!name || !coordinates || !indices) {
+      return false;
+    }
+
+    Points points(vertex_count);
+
+    for (uint64_t i = 0; i < vertex_count; i++) {
+      G4double xyz[3];
+      std::memcpy(xyz, coordinates + i * sizeof(xyz), sizeof(xyz));
+      points[i] = G4ThreeVector(xyz[0], xyz[1], xyz[2]);
+    }
+
+    Indices triangles(3 * triangle_count);
+
+    for (uint64_t i = 0; i < 3 * triangle_count; i++) {
+      uint32_t index;
+      std::memcpy(&index, indices + i * sizeof(index), sizeof(index));
+
+      if (index >= vertex_count) {
+        return false;
+      }
+
+      triangles[i] = index;
+    }
+
+    meshes.push_back(Mesh::New(std::move(points), std::move(triangles),
+                               G4String(std::string(name, name_size))));
+  }
+
+  return true;
+}
+
+inline void WriteMeshCache(G4String filepath, uint64_t hash,
+                           const Meshes &meshes) {
+  // Written under a temporary name and renamed into place, so other
+  // processes reading the same mesh never see a half-written cache.
+  auto path = MeshCachePath(filepath);
+#if defined(__unix__) || defined(__APPLE__)
+  auto temporary_path = path + "." + std::to_string(::getpid());
+#else
+  auto temporary_path = path + ".tmp";
+#endif
+
+  std::ofstream file(temporary_path, std::ios::binary);
+
+  if (!file.good()) {
+    return;
+  }
+
+  auto write = [&](const void *data, size_t size) {
+    static const char padding[8] = {0};
+
+    file.write((const char *)data, size);
+    file.write(padding, (8 - size % 8) % 8);
+  };
+
+  uint32_t header[2] = {MeshCacheVersion, (uint32_t)meshes.size()};
+  file.write(MeshCacheMagic, 8);
+  file.write((const char *)header, sizeof(header));
+  write(&hash, sizeof(hash));
+
+  for (const auto &mesh : meshes) {
+    std::vector<G4double> coordinates;
+    coordinates.reserve(3 * mesh->GetPoints().size());
+
+    for (const auto &point : mesh->GetPoints()) {
+      coordinates.insert(coordinates.end(), {point.x(), point.y(), point.z()});
+    }
+
+    std::vector<uint32_t> indices(mesh->GetIndices().begin(),
+                                  mesh->GetIndices().end());
+
+    auto name = mesh->GetName();
+    uint64_t sizes[3] = {coordinates.size() / 3, indices.size() / 3,
+                         name.size()};
+
+    write(sizes, sizeof(sizes));
+    write(name.data(), name.size());
+    write(coordinates.data(), coordinates.size() * sizeof(G4double));
+    write(indices.data(), indices.size() * sizeof(uint32_t));
+  }
+
+  file.close();
+
+  if (!file.good() || std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+    std::remove(temporary_path.c_str());
+  }
+}
+}
+}
+
+#endif
+
 namespace CADMesh {
 
 namespace File {
 
 inline G4bool BuiltInReader::Read(G4String filepath) {
+#ifndef CADMESH_DISABLE_MESH_CACHE
+  uint64_t hash = HashContents(MappedFile(filepath).View());
+  Meshes cached;
+
+  if (ReadMeshCache(filepath, hash, cached)) {
+    SetMeshes(cached);
+    return true;
+  }
+#endif
+
   File::Reader *reader = nullptr;
 
   auto type = TypeFromName(filepath);
@@ -2690,6 +3893,11 @@ inline G4bool BuiltInReader::Read(G4String filepath) {
   }
 
   SetMeshes(reader->GetMeshes());
+
+#ifndef CADMESH_DISABLE_MESH_CACHE
+  WriteMeshCache(filepath, hash, GetMeshes());
+#endif
+
   return true;
 }
 
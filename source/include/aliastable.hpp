@@ -0,0 +1,31 @@
+#ifndef ALIAS_TABLE_HPP
+#define ALIAS_TABLE_HPP
+#include <vector>
+#include "globals.hh"
+
+namespace ne697 {
+  // Walker's alias method: after an O(n) setup, picks index i with
+  // probability weights[i]/sum(weights) in constant time, from a single
+  // uniform random number
+  class AliasTable {
+    public:
+      AliasTable();
+      // Weights must not be negative, and at least one must be positive
+      AliasTable(std::vector<G4double> const& weights);
+
+      // Draws from the calling thread's engine
+      std::size_t sample() const;
+      // u uniform in [0, 1)
+      std::size_t sample(G4double u) const;
+
+      std::size_t size() const;
+      bool empty() const;
+
+    private:
+      // Column i keeps i with probability m_prob[i], otherwise m_alias[i]
+      std::vector<G4double> m_prob;
+      std::vector<std::size_t> m_alias;
+  };
+}
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef COLUMNAR_WRITER_HPP
+#define COLUMNAR_WRITER_HPP
+#include <cstdint>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+#include "hitwriter.hpp"
+
+namespace ne697 {
+  // Binary, column-oriented hit output. Layout (all little-endian):
+  //
+  //   "NE697COL" u32 version u32 0
+  //   row group 0: column 0 chunk, column 1 chunk, ... (each 8-byte aligned)
+  //   row group 1: ...
+  //   footer:
+  //     u32 ncolumns, then per column: u8 type, u16 name length, name, and
+  //       for dictionary columns u32 nentries + (u32 length, bytes) each
+  //     u64 nrowgroups, then per row group: u64 rows, u64 offset per column
+  //   u64 footer offset, "NE697COL"
+  //
+  // Types are 'i' (int32), 'u' (uint32 dictionary id), 'f' (float32) and 'd'
+  // (float64), in the same units as hits.csv. A reader can mmap the file,
+  // read the trailer and then only touch the column chunks it needs.
+  class ColumnarWriter: public HitWriter {
+    public:
+      ColumnarWriter(G4String const& path);
+      ~ColumnarWriter();
+
+      void write(Hit const& hit) override final;
+      void append(HitPart const& part) override final;
+      void close() override final;
+      std::size_t tell() override final;
+
+    private:
+      enum Column {
+        EventID, TrackID, ParentID, Particle, Process, Volume,
+        X, Y, Z, Energy, Time, Weight, n_columns
+      };
+      struct Dictionary {
+        std::unordered_map<std::string, std::uint32_t> ids;
+        std::vector<std::string> values;
+      };
+      struct RowGroup {
+        std::uint64_t rows;
+        std::uint64_t offsets[n_columns];
+      };
+
+      // Rows buffered before a row group is written out, which also bounds
+      // the memory used per writer
+      static constexpr std::size_t row_group_size = 1 << 16;
+
+      template<typename T> void put(Column column, T value);
+      std::uint32_t encode(Column column, std::string const& value);
+      // Same, for a StringTable id; remembers the answer in m_tableIDs
+      std::uint32_t encode(Column column, G4int id);
+      void flush_row_group();
+      // Pads the file to 8 bytes and writes one column chunk, returning the
+      // offset it starts at
+      std::uint64_t write_chunk(char const* data, std::size_t size);
+      void write_footer();
+
+      std::ofstream m_file;
+      std::size_t m_rows;
+      std::vector<char> m_columns[n_columns];
+      // Indexed by Column; only Particle, Process and Volume are used
+      Dictionary m_dicts[n_columns];
+      std::vector<std::int64_t> m_tableIDs[n_columns];
+      std::vector<RowGroup> m_rowGroups;
+  };
+}
+
+#endif
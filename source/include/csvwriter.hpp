@@ -0,0 +1,31 @@
+#ifndef CSV_WRITER_HPP
+#define CSV_WRITER_HPP
+#include <fstream>
+#include <vector>
+#include "hitwriter.hpp"
+
+namespace ne697 {
+  // Buffered text output, one line per Hit (the classic hits.csv)
+  class CsvWriter: public HitWriter {
+    public:
+      CsvWriter(G4String const& path, bool header = true);
+      ~CsvWriter();
+
+      void write(Hit const& hit) override final;
+      void append(HitPart const& part) override final;
+      void close() override final;
+      std::size_t tell() override final;
+
+      static void write_header(std::ostream& out);
+
+    private:
+      // Memory held per writer stays at this size no matter how many hits go
+      // through it
+      static constexpr std::size_t buffer_size = 1 << 20;
+
+      std::vector<char> m_buffer;
+      std::ofstream m_file;
+  };
+}
+
+#endif
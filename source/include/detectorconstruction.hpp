@@ -3,6 +3,8 @@
 #include "G4VUserDetectorConstruction.hh"
 #include "G4PVPlacement.hh"
 #include "G4LogicalVolume.hh"
+#include "G4Transform3D.hh"
+#include "G4Box.hh"
 
 namespace ne697 {
   // Forward declaration, to resolve circular dependency with GeometryMessenger
@@ -40,6 +42,33 @@ namespace ne697 {
       void set_det_geometry(G4String const& geometry);
       G4String const& get_det_geometry() const;
 
+      // Maximum deviation allowed when simplifying the CAD meshes; 0 keeps
+      // every facet
+      void set_mesh_tolerance(G4double const& tolerance);
+      G4double const& get_mesh_tolerance() const;
+
+      // Replace the CAD meshes with a G4Box, G4Tubs, G4Orb or capsule when
+      // one matches the surface to within this distance; 0 never does
+      void set_fit_tolerance(G4double const& tolerance);
+      G4double const& get_fit_tolerance() const;
+
+      // "tessellated" (one G4TessellatedSolid, or a fitted primitive) or
+      // "tetrahedral" (a G4AssemblyVolume of G4Tet, needs USE_TETGEN)
+      void set_mesh_backend(G4String const& backend);
+      G4String const& get_mesh_backend() const;
+
+      // TetGen radius-edge ratio bound for the tetrahedral backend; 0 turns
+      // quality refinement off
+      void set_tet_quality(G4double const& quality);
+      G4double const& get_tet_quality() const;
+
+      // Called by the messengers after every change. Once the geometry has
+      // been built, throws it away so Construct() runs again before the
+      // next run; the physics tables are kept
+      void reinitialize();
+      // Cheaper version of reinitialize() for det_radius, det_thickness and
+      // det_geometry: resizes the world box and detector shell in place
+      void update_detector();
 
 
     private:
@@ -48,8 +77,25 @@ namespace ne697 {
       // we can ask for them anywhere in the code by name
       void build_materials();
 
+      // The detector shell for m_detGeometry and m_detRadius
+      G4VSolid* build_det_solid() const;
+      // Hands the settings the geometry was just built with to the other
+      // threads, see GeometryParameters
+      void publish_parameters() const;
+      // The PEN capsule as a single solid, using the fit and mesh
+      // tolerances
+      G4VSolid* build_pen_solid();
+      // Places the PEN capsule as tetrahedra; false if TetGen isn't built in
+      bool place_pen_tets(G4LogicalVolume* world_log, G4Material* material,
+          G4Transform3D placement);
+
       // List of G4LogicalVolumes we want to connect to the SensitiveDetector
       std::vector<G4LogicalVolume*> m_trackingVols;
+      // What update_detector() changes; null until Construct() has run, and
+      // again after reinitialize()
+      G4Box* m_worldSolid;
+      G4LogicalVolume* m_detLog;
+      G4VPhysicalVolume* m_detPhys;
 
       GeometryMessenger* m_gmessenger;
       MaterialMessenger* m_mmessenger;
@@ -62,6 +108,10 @@ namespace ne697 {
       G4String m_detMaterial;
       G4String m_detGeometry;
       G4String m_worldMaterial;
+      G4double m_meshTolerance;
+      G4double m_fitTolerance;
+      G4String m_meshBackend;
+      G4double m_tetQuality;
   };
 }
 
@@ -8,7 +8,12 @@ namespace ne697 {
       EventAction();
       ~EventAction();
 
+      void BeginOfEventAction(G4Event const* event) override final;
       void EndOfEventAction(G4Event const* event) override final;
+
+    private:
+      // This thread's CPU time at the start of the current event, in ms
+      G4double m_eventStart;
   };
 }
 
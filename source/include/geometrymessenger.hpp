@@ -2,6 +2,7 @@
 #define GEOMETRY_MESSENGER_HPP
 #include "G4UImessenger.hh"
 #include "G4UIcmdWith3VectorAndUnit.hh"
+#include "G4UIcmdWithADouble.hh"
 #include "G4UIcmdWithADoubleAndUnit.hh"
 #include "G4UIcmdWithAString.hh"
 
@@ -25,6 +26,10 @@ namespace ne697 {
     G4UIcmdWithADoubleAndUnit* m_detThicknessCmd;
     G4UIcmdWithADoubleAndUnit* m_detRadiusCmd;
     G4UIcmdWithAString*        m_detGeometryCmd;
+    G4UIcmdWithADoubleAndUnit* m_meshToleranceCmd;
+    G4UIcmdWithADoubleAndUnit* m_fitToleranceCmd;
+    G4UIcmdWithAString*        m_meshBackendCmd;
+    G4UIcmdWithADouble*        m_tetQualityCmd;
 
   };
 }
@@ -0,0 +1,30 @@
+#ifndef GEOMETRY_PARAMETERS_HPP
+#define GEOMETRY_PARAMETERS_HPP
+#include "globals.hh"
+
+namespace ne697 {
+  // Read-only copy of the DetectorConstruction settings that the built
+  // geometry actually uses. DetectorConstruction publishes a new one on the
+  // master after every Construct() and in-place update; any thread can
+  // read the latest with current(), which is a single atomic load.
+  //
+  // Published snapshots are never changed, and are kept until exit, so a
+  // pointer from current() stays valid even after a newer one comes out
+  struct GeometryParameters {
+    G4double det_radius;
+    G4double det_thickness;
+    G4String det_geometry;
+    G4String det_material;
+    G4String world_material;
+    G4double world_half_length;
+    // Counts up from 1 with every publish
+    G4int version;
+
+    // nullptr before the first Construct()
+    static GeometryParameters const* current();
+    // Sets version and makes a copy of parameters the current snapshot
+    static void publish(GeometryParameters const& parameters);
+  };
+}
+
+#endif
@@ -1,7 +1,11 @@
 #ifndef GUN_MESSENGER_HPP
 #define GUN_MESSENGER_HPP
 #include "G4UImessenger.hh"
+#include "G4UIcmdWithADouble.hh"
 #include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithoutParameter.hh"
 
 namespace ne697 {
   // Forward declaration, to resolve circular dependency with DetectorConstruction
@@ -21,6 +25,19 @@ namespace ne697 {
     PGA* m_pga;
     G4UIdirectory* m_directory;
     G4UIcmdWithADoubleAndUnit* m_gunOffsetCmd;
+    G4UIcmdWithAnInteger* m_batchSizeCmd;
+    G4UIcmdWithAnInteger* m_benchmarkCmd;
+    G4UIcmdWithAString* m_positionModeCmd;
+    G4UIcmdWithAString* m_sourceVolumeCmd;
+    G4UIcmdWithAString* m_directionModeCmd;
+    G4UIcmdWithAString* m_biasVolumeCmd;
+    G4UIcmdWithADouble* m_biasFractionCmd;
+    G4UIcommand* m_spectrumLineCmd;
+    G4UIcmdWithoutParameter* m_spectrumClearCmd;
+    G4UIcmdWithAString* m_spectrumFileCmd;
+    G4UIcmdWithAnInteger* m_spectrumTestCmd;
+    G4UIcommand* m_isotopeCmd;
+    G4UIcmdWithoutParameter* m_isotopeClearCmd;
   };
 }
 
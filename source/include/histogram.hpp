@@ -0,0 +1,48 @@
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+#include <ostream>
+#include <vector>
+#include "globals.hh"
+
+namespace ne697 {
+  // Fixed-width 1D histogram with underflow and overflow bins. Every thread
+  // fills its own copy (owned by its Run), so there are no locks or atomics
+  // in here; copies are added together bin by bin in Run::Merge()
+  class Histogram {
+    public:
+      // nbins = 0 makes a disabled histogram that ignores fill()
+      Histogram(G4int nbins = 0, G4double min = 0., G4double max = 1.);
+
+      void fill(G4double value, G4double weight = 1.);
+      // Adds another histogram with the same binning to this one
+      void add(Histogram const& other);
+
+      bool enabled() const;
+      G4int get_nbins() const;
+      G4double get_min() const;
+      G4double get_max() const;
+      // Bin -1 is the underflow and bin nbins is the overflow
+      G4double get_bin(G4int bin) const;
+      // Sum of the squared weights in a bin; its square root is the bin's
+      // statistical error
+      G4double get_sumw2(G4int bin) const;
+
+      // One CSV row per bin (including underflow and overflow), with the
+      // edges divided by unit; see RunAction::write_histograms()
+      void write(std::ostream& out, G4String const& prefix,
+          G4double unit) const;
+
+    private:
+      G4int m_nbins;
+      G4double m_min;
+      G4double m_max;
+      // nbins / (max - min), so fill() is a multiply instead of a divide
+      G4double m_scale;
+      // m_bins[0] is the underflow, m_bins[nbins + 1] the overflow
+      std::vector<G4double> m_bins;
+      // Same layout as m_bins
+      std::vector<G4double> m_sumw2;
+  };
+}
+
+#endif
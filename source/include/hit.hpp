@@ -6,11 +6,14 @@
 #include "G4VHit.hh"
 
 namespace ne697 {
+  // Names are stored as StringTable ids, so a Hit is a small fixed-size
+  // object that is cheap to create and copy; the get*() name accessors look
+  // the strings back up for output
   class Hit: public G4VHit {
     public:
-      Hit(int trackid, int parent_id, G4String const& volume,
-        G4String const& particle, G4String const& process,
-        G4ThreeVector const& position, float energy, double time);
+      Hit(int trackid, int parent_id, G4int volume_id, G4int particle_id,
+        G4int process_id, G4ThreeVector const& position, float energy,
+        double time, float weight);
 
       inline void* operator new(std::size_t);
       inline void operator delete(void* hit);
@@ -22,22 +25,28 @@ namespace ne697 {
       G4String const& getVolume() const;
       G4String const& getParticle() const;
       G4String const& getProcess() const;
+      G4int getVolumeID() const;
+      G4int getParticleID() const;
+      G4int getProcessID() const;
       G4ThreeVector const& getPosition() const;
       float getEnergy() const;
       double getTime() const;
+      float getWeight() const;
 
      private:
       int m_eventID;
       int m_trackID;
       /// Track ID of the parent
       int m_parentID;
-      G4String m_volume;
-      G4String m_particle;
+      G4int m_volumeID;
+      G4int m_particleID;
       /// Process that created this particle
-      G4String m_process;
+      G4int m_processID;
       G4ThreeVector m_position;
       float m_energy;
       double m_time;
+      /// Statistical weight of the track, 1 unless the source is biased
+      float m_weight;
   };
 
   /****** GEANT4 BOILERPLATE ******/
@@ -0,0 +1,46 @@
+#ifndef HIT_WRITER_HPP
+#define HIT_WRITER_HPP
+#include <ostream>
+#include "hit.hpp"
+
+namespace ne697 {
+  // A finished part file written by one thread while streaming, and how many
+  // rows it holds
+  struct HitPart {
+    G4String path;
+    std::size_t count;
+  };
+
+  // Base class for the hit output formats. While streaming, every thread
+  // owns its own HitWriter, so nothing in here needs a lock
+  class HitWriter {
+    public:
+      virtual ~HitWriter();
+
+      virtual void write(Hit const& hit) = 0;
+      // Copies all rows of a part file written by the same kind of writer
+      // onto the end of this one
+      virtual void append(HitPart const& part) = 0;
+      // Flushes everything and closes the file; safe to call more than once
+      virtual void close() = 0;
+      // Current size of the output in bytes, used for the streaming index
+      virtual std::size_t tell() = 0;
+
+      G4String const& get_path() const;
+      std::size_t get_count() const;
+
+      // format is one of the /ne697/run/format candidates. header = false
+      // is used for the per-thread parts, which get merged under a single
+      // header at the end of the run
+      static HitWriter* create(G4String const& format, G4String const& path,
+          bool header = true);
+
+    protected:
+      HitWriter(G4String const& path);
+
+      G4String m_path;
+      std::size_t m_count;
+  };
+}
+
+#endif
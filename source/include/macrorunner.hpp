@@ -0,0 +1,47 @@
+#ifndef MACRO_RUNNER_HPP
+#define MACRO_RUNNER_HPP
+#include <set>
+#include <utility>
+#include <vector>
+#include "globals.hh"
+
+namespace ne697 {
+  // Batch front end used by main(): runs macro files one command at a time
+  // (like /control/execute), so that command-line overrides can replace the
+  // values the macros set.
+  //
+  // An override for a command that appears in any of the macros (or in a
+  // macro they /control/execute) replaces the value on each of those
+  // lines. Overrides for commands no macro uses are applied before the
+  // first macro instead.
+  class MacroRunner {
+    public:
+      MacroRunner();
+
+      // command is the full path, e.g. /ne697/geometry/det_radius, and
+      // value the rest of the line, e.g. "40 cm"
+      void add_override(G4String const& command, G4String const& value);
+
+      // Runs the macros in order. Stops at the first file that can't be
+      // read, unknown command or command the master rejects, and returns
+      // false after printing why. Mistakes that only the workers can see,
+      // like a /ne697/gun/spectrum_file that can't be read, are reported
+      // by the workers but don't stop the job
+      bool run(std::vector<G4String> const& macros);
+
+    private:
+      // The commands in a macro (and the macros it executes), one complete
+      // command per entry, with comments and line continuations resolved
+      bool read_macro(G4String const& path, std::vector<G4String>& commands)
+        const;
+      void collect_commands(G4String const& path, std::set<G4String>& paths,
+          G4int depth) const;
+      bool execute(G4String const& path, G4int depth);
+      bool apply(G4String const& command);
+      G4String find_macro(G4String const& path) const;
+
+      std::vector<std::pair<G4String, G4String>> m_overrides;
+  };
+}
+
+#endif
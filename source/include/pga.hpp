@@ -1,9 +1,15 @@
 #ifndef PGA_HPP
 #define PGA_HPP
 
+#include <utility>
+#include <vector>
+#include "G4Navigator.hh"
 #include "G4ParticleGun.hh"
+#include "G4RotationMatrix.hh"
 #include "G4VUserPrimaryGeneratorAction.hh"
-#include "detectorconstruction.hpp"
+#include "aliastable.hpp"
+#include "geometryparameters.hpp"
+#include "spectrum.hpp"
 
 namespace ne697 {
 
@@ -19,14 +25,142 @@ namespace ne697 {
       void set_gun_offset(G4double const& offset);
       G4double const& get_gun_offset() const;
 
+      // Number of source positions drawn at once. 1 draws each event's
+      // position when it's needed, which keeps every event reproducible
+      // from its own seed in MT mode; larger batches share one event's
+      // random numbers with the events after it on the same thread
+      void set_batch_size(G4int const& size);
+      G4int const& get_batch_size() const;
+
+      // Times drawing n_events positions one at a time and in batches of
+      // the current batch size, and prints the cost per event
+      void benchmark(G4int n_events);
+
+      // Where primaries start: "halfcylinder" (the original source, the
+      // half of the detector shell's inside with y > 0),
+      // "point" (at m_offset along y), or "volume"/"surface" (uniform in or
+      // on the source volume)
+      void set_position_mode(G4String const& mode);
+      G4String get_position_mode() const;
+      // Physical volume name for the volume and surface modes. Volume mode
+      // leaves out the volume's daughters
+      void set_source_volume(G4String const& name);
+      G4String const& get_source_volume() const;
+
+      // "gun" keeps whatever /gun/direction says, "isotropic" draws a new
+      // direction for every primary, and "biased" is isotropic but sends
+      // more primaries into the cone around the bias volume, weighting each
+      // so that weighted tallies match the isotropic source
+      void set_direction_mode(G4String const& mode);
+      G4String const& get_direction_mode() const;
+      // Physical volume the biased mode aims at
+      void set_bias_volume(G4String const& name);
+      G4String const& get_bias_volume() const;
+      // Share of biased primaries drawn inside the cone; the rest are
+      // isotropic, so every direction can still happen
+      void set_bias_fraction(G4double const& fraction);
+      G4double const& get_bias_fraction() const;
+
+      // Energy spectrum; while it has entries, each primary's energy is
+      // drawn from it instead of using the /gun/energy energy
+      void add_spectrum_line(G4double const& energy, G4double const& weight);
+      // Adds the lines and continuum bins in a file (see Spectrum::load())
+      bool load_spectrum(G4String const& path);
+      void clear_spectrum();
+      std::size_t get_spectrum_size() const;
+      // Checks and times the spectrum sampling, see Spectrum::test()
+      void test_spectrum(G4int n_samples);
+
+      // Background isotopes, each fired at rest with probability
+      // proportional to its weight (its activity). While the list isn't
+      // empty this replaces the /gun/ particle and energy
+      void add_isotope(G4int z, G4int a, G4double const& weight);
+      void clear_isotopes();
+      std::size_t get_isotope_count() const;
+
     private:
-      G4ParticleGun* m_gun;
+      enum PositionMode {HalfCylinder, Point, Volume, Surface};
 
-      DetectorConstruction* m_geo;
+      // Source position for the next event, in the current position mode
+      G4ThreeVector next_position();
+      // Half-cylinder position from the batch buffer if batching is on
+      G4ThreeVector next_halfcylinder();
+      // One position straight from the engine
+      G4ThreeVector sample_position() const;
+      // Refills the buffer with m_batchSize positions
+      void fill_positions();
+      G4ThreeVector sample_volume();
+      G4ThreeVector sample_surface() const;
+      // Direction from position in the biased mode, and the weight that
+      // goes with it: isotropic pdf / the pdf it was drawn from
+      G4ThreeVector sample_biased(G4ThreeVector const& position,
+          G4double& weight) const;
+      // Looks up the source volume and ions for the current run, since the
+      // geometry may have been rebuilt since the last one
+      void update_source();
+      // Picks up the detector radius and shape if a new GeometryParameters
+      // has been published
+      void update_geometry();
+      // Puts back the /gun/ particle and energy saved when the isotopes or
+      // the spectrum took over, once neither is left to replace them
+      void restore_gun();
+
+      G4ParticleGun* m_gun;
 
       GunMessenger* m_messenger;
 
+      // The snapshot m_detRadius and m_fSphere came from
+      GeometryParameters const* m_geometry;
+      G4double m_detRadius;
+      bool m_fSphere;
+
       G4double m_offset;
+
+      G4int m_batchSize;
+      // Batch buffer: the raw draws, then one array per coordinate so the
+      // trig loop can be vectorised. m_next is the next unused position
+      std::vector<G4double> m_random;
+      std::vector<G4double> m_x;
+      std::vector<G4double> m_y;
+      std::vector<G4double> m_z;
+      std::size_t m_next;
+
+      PositionMode m_positionMode;
+      G4String m_sourceName;
+      G4String m_directionMode;
+      G4String m_biasName;
+      G4double m_biasFraction;
+      // Run the source below was looked up for
+      G4int m_sourceRun;
+      G4VPhysicalVolume* m_sourceVolume;
+      // Global placement of the source volume (global = rotation*local +
+      // translation) and its global bounding box
+      G4RotationMatrix m_sourceRotation;
+      G4ThreeVector m_sourceTranslation;
+      G4ThreeVector m_sourceMin;
+      G4ThreeVector m_sourceMax;
+      // Global sphere around the bias volume's bounding box; the cone is
+      // the one this sphere fills as seen from the source point
+      G4VPhysicalVolume* m_biasVolume;
+      G4ThreeVector m_biasCentre;
+      G4double m_biasRadius;
+      // Whether this run has said that it isn't biasing at-rest primaries
+      bool m_fWarnedBias;
+      // Separate from the tracking navigator, which is in the middle of
+      // the event loop
+      G4Navigator* m_navigator;
+
+      Spectrum m_spectrum;
+
+      std::vector<std::pair<G4int, G4int>> m_isotopes;
+      std::vector<G4double> m_isotopeWeights;
+      AliasTable m_isotopeTable;
+      std::vector<G4ParticleDefinition*> m_isotopeIons;
+      // The /gun/ particle and energy from before the isotopes or the
+      // spectrum started overwriting them, while m_fGunSaved
+      bool m_fGunSaved;
+      G4ParticleDefinition* m_gunParticle;
+      G4double m_gunEnergy;
   };
 }
 
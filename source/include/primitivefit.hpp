@@ -0,0 +1,69 @@
+#ifndef PRIMITIVE_FIT_HPP
+#define PRIMITIVE_FIT_HPP
+#include <vector>
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4VSolid.hh"
+
+namespace ne697 {
+  // Checks whether a closed triangle mesh is really a sphere, box, cylinder
+  // or capsule, so DetectorConstruction can hand Geant4 the analytic solid
+  // instead of a G4TessellatedSolid. The mesh is given the way CADMesh
+  // stores it: each vertex once, plus three indices per triangle
+  class PrimitiveFit {
+    public:
+      PrimitiveFit(std::vector<G4ThreeVector> const& points,
+          std::vector<std::size_t> const& indices);
+
+      // Returns the best-fitting solid, placed and oriented like the mesh,
+      // or nullptr when no shape is within tolerance everywhere
+      G4VSolid* build_solid(G4String const& name, G4double tolerance);
+
+      // The shape and largest surface deviation of the best fit found by
+      // the last build_solid() call, whether or not it was accepted
+      G4String const& get_shape() const;
+      G4double get_error() const;
+
+    private:
+      enum Shape {Sphere, Box, Tube, Capsule};
+
+      struct Candidate {
+        Shape shape;
+        // Placement of the shape's own frame; the tube and capsule axes
+        // are along axes[2]
+        G4ThreeVector center;
+        G4ThreeVector axes[3];
+        // Sphere: radius. Box: three half lengths. Tube and capsule:
+        // radius, then half length of the straight section
+        G4double size[3];
+        G4double error;
+        G4double volume;
+      };
+
+      // Largest distance from the mesh samples to the candidate's surface
+      G4double surface_error(Candidate const& candidate) const;
+      void fit_sphere(std::vector<Candidate>& candidates) const;
+      void fit_box(G4ThreeVector const axes[3],
+          std::vector<Candidate>& candidates) const;
+      void fit_round(G4ThreeVector const axes[3],
+          std::vector<Candidate>& candidates) const;
+
+      // Vertices, facet centroids and edge midpoints: enough to catch
+      // facets that bulge away from the candidate between vertices
+      std::vector<G4ThreeVector> m_samples;
+      G4double m_area;
+      G4double m_volume;
+      G4ThreeVector m_centroid;
+      // Principal axes of the surface's second moment
+      G4ThreeVector m_principal[3];
+      // Normals of the largest facet and the largest facet perpendicular
+      // to it, which line up with a box's faces when PCA can't
+      G4ThreeVector m_faceAxes[3];
+      bool m_fFaceAxes;
+
+      G4String m_shape;
+      G4double m_error;
+  };
+}
+
+#endif
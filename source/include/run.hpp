@@ -1,21 +1,87 @@
 #ifndef RUN_HPP
 #define RUN_HPP
+#include <map>
 #include "G4Run.hh"
+#include "histogram.hpp"
 #include "hit.hpp"
+#include "hitwriter.hpp"
 
 namespace ne697 {
+  // Hits are kept as a list of chunks: each thread fills its own chunk, and
+  // merging just moves the workers' chunks over to the master
+  typedef std::vector<std::vector<Hit>> HitChunks;
+
   class Run: public G4Run {
     public:
+      // Deposited energy summed per volume per event, and per-hit time and
+      // radius (distance from the z axis); each is kept per volume, and
+      // filled with the statistical weight of the event or hit
+      enum HistogramType {
+        EnergyHist, TimeHist, RadiusHist, n_histograms
+      };
+      // Histograms per volume, keyed by StringTable id
+      typedef std::map<G4int, Histogram> VolumeHistograms;
+
       Run();
       ~Run();
 
       void RecordEvent(G4Event const* event) override final;
       void Merge(G4Run const* from_run) override final;
 
-      std::vector<Hit> get_hits() const;
+      HitChunks const& get_hits() const;
+      std::size_t get_hit_count() const;
+      // Wall time spent in Merge() and how many runs were merged in, for
+      // the end-of-run report
+      G4double get_merge_time() const;
+      G4int get_merge_count() const;
+
+      // Per-event CPU time in ms, measured by EventAction on the thread
+      // that ran the event; merged like everything else
+      void add_event_time(G4double time);
+      G4int get_timed_events() const;
+      G4double get_event_time_mean() const;
+      G4double get_event_time_rms() const;
+      G4double get_event_time_max() const;
+
+      // Streaming mode: with a path set, each thread writes its hits to its
+      // own part file (in the given /ne697/run/format) as events come in
+      // instead of keeping them in m_hits
+      void set_stream(G4String const& path, G4String const& format);
+      // Flushes this run's part file (if any) and returns it along with all
+      // of the parts collected from other threads in Merge()
+      std::vector<HitPart> close_stream() const;
+
+      // With store = false, hits are not kept in memory (histograms and
+      // streaming still see them)
+      void store_hits(bool store);
+      // Binning for one histogram type; a disabled Histogram turns it off
+      void set_histogram(HistogramType type, Histogram const& binning);
+      VolumeHistograms const& get_histograms(HistogramType type) const;
 
     private:
-      std::vector<Hit> m_hits;
+      // This thread's histogram of the given type for one volume, created
+      // with m_binning the first time the volume shows up
+      Histogram& histogram(HistogramType type, G4int volume_id);
+
+      HitChunks m_hits;
+      bool m_fStoreHits;
+      Histogram m_binning[n_histograms];
+      VolumeHistograms m_histograms[n_histograms];
+      // Energy per volume id for the current event, reused between events
+      std::vector<std::pair<G4int, G4double>> m_eventEdep;
+      G4double m_mergeTime;
+      G4int m_mergeCount;
+      G4int m_timedEvents;
+      G4double m_eventTimeSum;
+      G4double m_eventTimeSum2;
+      G4double m_eventTimeMax;
+
+      G4String m_streamPath;
+      G4String m_streamFormat;
+      // Only created on the first hit, so the master in MT mode never opens
+      // an empty part file
+      HitWriter* m_writer;
+      std::vector<HitPart> m_parts;
   };
 }
 
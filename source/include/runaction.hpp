@@ -3,6 +3,8 @@
 
 #include "G4UserRunAction.hh"
 #include "hit.hpp"
+#include "hitwriter.hpp"
+#include "run.hpp"
 
 namespace ne697 {
   // Forward declaration, to address circular dependency with RunAction
@@ -22,13 +24,30 @@ namespace ne697 {
       void save_data(bool save);
       G4String const& get_path() const;
       void set_path(G4String const& path);
+      bool stream_hits() const;
+      void stream_hits(bool stream);
+      G4String const& get_format() const;
+      void set_format(G4String const& format);
+      // Binning for each Run histogram type, handed to every new Run
+      Histogram const& get_histogram(Run::HistogramType type) const;
+      void set_histogram(Run::HistogramType type, Histogram const& binning);
+      G4String const& get_histogram_path() const;
+      void set_histogram_path(G4String const& path);
 
     private:
-      void write_hits(std::vector<Hit> hits);
+      void write_hits(HitChunks const& hits);
+      void write_histograms(Run const* run);
+      // Merges the per-thread part files into m_path and writes an index of
+      // where each part starts next to it
+      void merge_parts(std::vector<HitPart> const& parts);
 
       RunMessenger* m_messenger;
       bool m_fSaveData;
+      bool m_fStreamHits;
       G4String m_path;
+      G4String m_format;
+      Histogram m_histograms[Run::n_histograms];
+      G4String m_histogramPath;
   };
 }
 
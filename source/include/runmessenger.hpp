@@ -21,6 +21,10 @@ namespace ne697 {
     G4UIdirectory* m_directory;
     G4UIcmdWithABool* m_saveDataCmd;
     G4UIcmdWithAString* m_savePathCmd;
+    G4UIcmdWithABool* m_streamHitsCmd;
+    G4UIcmdWithAString* m_formatCmd;
+    G4UIcommand* m_histogramCmd;
+    G4UIcmdWithAString* m_histogramPathCmd;
   };  
 }
 
@@ -0,0 +1,30 @@
+#ifndef SD_MESSENGER_HPP
+#define SD_MESSENGER_HPP
+#include "G4UImessenger.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAString.hh"
+
+namespace ne697 {
+  // Forward declaration, to resolve circular dependency with SensitiveDetector
+  // You still need to #include "sensitivedetector.hpp" in sdmessenger.cpp
+  class SensitiveDetector;
+
+  class SDMessenger: public G4UImessenger {
+  public:
+    SDMessenger(SensitiveDetector* sd);
+    ~SDMessenger();
+
+    void SetNewValue(G4UIcommand* cmd, G4String val) override final;
+
+  private:
+    SensitiveDetector* m_sd;
+    G4UIdirectory* m_directory;
+    G4UIcmdWithAString* m_particlesCmd;
+    G4UIcmdWithADoubleAndUnit* m_minEdepCmd;
+    G4UIcmdWithAString* m_volumesCmd;
+    G4UIcmdWithABool* m_aggregateCmd;
+  };
+}
+
+#endif
@@ -1,20 +1,72 @@
 #ifndef SENSITIVE_DETECTOR_HPP
 #define SENSITIVE_DETECTOR_HPP
 #include "G4VSensitiveDetector.hh"
+#include "G4LogicalVolume.hh"
+#include "G4ParticleDefinition.hh"
 #include "hit.hpp"
 
 namespace ne697 {
+  // Forward declaration, to resolve circular dependency with SDMessenger
+  // You still need to #include "sdmessenger.hpp" in sensitivedetector.cpp
+  class SDMessenger;
+
   class SensitiveDetector : public G4VSensitiveDetector {
   public:
-    SensitiveDetector(G4String const& name);
+    // volumes are the logical volumes this SD is attached to, which the
+    // aggregation mode keeps one running total for each
+    SensitiveDetector(G4String const& name,
+                      std::vector<G4LogicalVolume*> const& volumes);
+    ~SensitiveDetector();
 
     void Initialize(G4HCofThisEvent* hc) override final;
     G4bool ProcessHits(G4Step* step, G4TouchableHistory*) override final;
+    void EndOfEvent(G4HCofThisEvent* hc) override final;
+
+    // Hit filter, applied to the G4Step before any Hit is made. Names are
+    // space-separated; "all" (or an empty list) lets everything through
+    void set_particles(G4String const& names);
+    G4String get_particles() const;
+    void set_min_edep(G4double const& edep);
+    G4double const& get_min_edep() const;
+    void set_volumes(G4String const& names);
+    G4String get_volumes() const;
+
+    // Swaps in the volumes of a rebuilt geometry, and looks the volume
+    // filter up again by name
+    void set_tracked_volumes(std::vector<G4LogicalVolume*> const& volumes);
+
+    // Aggregation mode: instead of one Hit per step, sum the deposited
+    // energy per tracked volume and make one Hit per volume at the end of
+    // the event (edep-weighted mean position, earliest time, and the weight
+    // of the first track to deposit energy there)
+    void set_aggregate(bool aggregate);
+    bool get_aggregate() const;
 
   private:
     int m_id;
     HitsCollection* m_hitsCollection;
+    SDMessenger* m_messenger;
+
+    // Stored as pointers so that the check in ProcessHits is a handful of
+    // pointer compares; these lists are only ever a few entries long
+    std::vector<G4ParticleDefinition const*> m_particles;
+    // Steps must deposit strictly more than this to make a Hit
+    G4double m_minEdep;
+    std::vector<G4LogicalVolume const*> m_volumes;
+    G4String m_volumeNames;
+
+    bool m_fAggregate;
+    // Everything below has one entry per tracked volume, sized once in the
+    // constructor and reset at the start of each event
+    std::vector<G4LogicalVolume const*> m_trackedVols;
+    std::vector<G4double> m_sumEdep;
+    std::vector<G4ThreeVector> m_sumPosition;
+    std::vector<G4double> m_firstTime;
+    std::vector<G4int> m_volumeIDs;
+    // Every track in an event carries its primary's weight, so any one of
+    // them will do
+    std::vector<G4double> m_weights;
   };
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,50 @@
+#ifndef SPECTRUM_HPP
+#define SPECTRUM_HPP
+#include <vector>
+#include "globals.hh"
+#include "aliastable.hpp"
+
+namespace ne697 {
+  // Energy spectrum made of discrete lines and flat continuum bins, sampled
+  // in constant time through an AliasTable over all the entries. Each PGA
+  // (so each thread) has its own
+  class Spectrum {
+    public:
+      Spectrum();
+
+      void add_line(G4double energy, G4double weight);
+      void add_continuum(G4double low, G4double high, G4double weight);
+      // Appends the entries in a text file, one per line, '#' starting a
+      // comment:
+      //   line <energy> <unit> <weight>
+      //   continuum <low> <high> <unit> <weight>
+      // On any error, prints where and returns false without adding
+      // anything
+      bool load(G4String const& path);
+      void clear();
+
+      std::size_t size() const;
+      bool empty() const;
+
+      // Draws from the calling thread's engine
+      G4double sample();
+
+      // Chi-square test of n_samples entry draws against the weights, and
+      // the cost per draw compared with a binary search of the cumulative
+      // distribution
+      void test(G4int n_samples);
+
+    private:
+      // (Re)builds m_table if entries were added since the last draw
+      void build();
+
+      // Lines have m_low == m_high
+      std::vector<G4double> m_low;
+      std::vector<G4double> m_high;
+      std::vector<G4double> m_weights;
+      AliasTable m_table;
+      bool m_fBuilt;
+  };
+}
+
+#endif
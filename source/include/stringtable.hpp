@@ -0,0 +1,24 @@
+#ifndef STRING_TABLE_HPP
+#define STRING_TABLE_HPP
+#include "globals.hh"
+
+namespace ne697 {
+  // Global table that hands out small integer ids for the names that repeat
+  // on every Hit (volume, particle and creator process), so a Hit can carry
+  // ids instead of its own copies of the strings.
+  //
+  // intern() is thread-safe: every thread keeps a private cache of the names
+  // it has already seen, and only takes the lock for names that are new to
+  // it. Ids are never reused or removed, so lookup() doesn't need a lock.
+  class StringTable {
+    public:
+      // Returns the id for name, adding it to the table the first time
+      static G4int intern(G4String const& name);
+      // The name for an id returned by intern()
+      static G4String const& lookup(G4int id);
+      // Number of names interned so far; valid ids are [0, size())
+      static std::size_t size();
+  };
+}
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef SWEEP_HPP
+#define SWEEP_HPP
+#include <vector>
+#include "globals.hh"
+
+namespace ne697 {
+  // Forward declaration, to resolve circular dependency with SweepMessenger
+  // You still need to #include "sweepmessenger.hpp" in sweep.cpp
+  class SweepMessenger;
+
+  // Runs one UI command over a list of values in a single process, with a
+  // run per value, so the physics tables are only built once for the whole
+  // sweep. Geometry and material commands throw the built geometry away
+  // (see DetectorConstruction::reinitialize()); anything else, like
+  // /gun/energy, just takes effect at the next run.
+  //
+  // Lives on the master thread only, created in main()
+  class Sweep {
+    public:
+      Sweep();
+      ~Sweep();
+
+      // Full command path, e.g. /ne697/material/det_material
+      void set_parameter(G4String const& command);
+      G4String const& get_parameter() const;
+
+      // Comma-separated, so values can carry units: "1 cm, 2 cm, 5 cm"
+      void set_values(G4String const& values);
+      G4String get_values() const;
+
+      // Run i writes its hits to <stem>_<i><extension> and its histograms
+      // to <stem>_<i>_histograms.csv
+      void set_path(G4String const& path);
+      G4String const& get_path() const;
+
+      // One run of n_events per value. Stops at the first command that
+      // fails, and returns false after printing why. Either way the hits
+      // and histogram paths are put back afterwards; the swept command
+      // keeps the last value it was given
+      bool run(G4int n_events);
+
+    private:
+      // The runs themselves, writing to <stem>_<i><extension>
+      bool run_values(G4int n_events, G4String const& stem,
+          G4String const& extension);
+
+      SweepMessenger* m_messenger;
+      G4String m_parameter;
+      std::vector<G4String> m_values;
+      G4String m_path;
+  };
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef SWEEP_MESSENGER_HPP
+#define SWEEP_MESSENGER_HPP
+#include "G4UImessenger.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+namespace ne697 {
+  // Forward declaration, to resolve circular dependency with Sweep
+  // You still need to #include "sweep.hpp" in sweepmessenger.cpp
+  class Sweep;
+
+  class SweepMessenger: public G4UImessenger {
+  public:
+    SweepMessenger(Sweep* sweep);
+    ~SweepMessenger();
+
+    void SetNewValue(G4UIcommand* cmd, G4String val) override final;
+
+  private:
+    Sweep* m_sweep;
+    G4UIdirectory* m_directory;
+    G4UIcmdWithAString* m_parameterCmd;
+    G4UIcmdWithAString* m_valuesCmd;
+    G4UIcmdWithAString* m_savePathCmd;
+    G4UIcmdWithAnInteger* m_beamOnCmd;
+  };
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef WORKER_COMMANDS_HPP
+#define WORKER_COMMANDS_HPP
+
+namespace ne697 {
+  class PGA;
+  class SensitiveDetector;
+
+  // In MT and tasking mode the PGA (with /gun/ and /ne697/gun/) and the
+  // SensitiveDetector (with /ne697/sd/) only exist on the workers, so the
+  // master would pass their commands on unchecked, typos and all. This gives
+  // the master its own copies of both, which are never used for a run, so
+  // that it knows those commands and checks their parameters before they
+  // are broadcast. GunMessenger and SDMessenger don't act on these copies.
+  //
+  // Lives on the master thread only, created in main() when there are
+  // worker threads
+  class WorkerCommands {
+    public:
+      WorkerCommands();
+      ~WorkerCommands();
+
+    private:
+      PGA* m_pga;
+      SensitiveDetector* m_sd;
+  };
+}
+
+#endif
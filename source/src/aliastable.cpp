@@ -0,0 +1,65 @@
+#include "aliastable.hpp"
+#include "Randomize.hh"
+
+namespace ne697 {
+  AliasTable::AliasTable():
+    m_prob(),
+    m_alias()
+  {}
+
+  AliasTable::AliasTable(std::vector<G4double> const& weights):
+    m_prob(weights.size(), 1.),
+    m_alias(weights.size())
+  {
+    auto const n = weights.size();
+    G4double sum = 0.;
+    for (auto weight : weights) {
+      sum += weight;
+    }
+    // Vose's version: scale so the mean column is 1, then fill each short
+    // column from a tall one
+    std::vector<G4double> scaled(n);
+    std::vector<std::size_t> small;
+    std::vector<std::size_t> large;
+    for (std::size_t i = 0; i < n; ++i) {
+      scaled[i] = weights[i]*n/sum;
+      m_alias[i] = i;
+      (scaled[i] < 1. ? small : large).push_back(i);
+    }
+    while (!small.empty() && !large.empty()) {
+      auto const s = small.back();
+      small.pop_back();
+      auto const l = large.back();
+      m_prob[s] = scaled[s];
+      m_alias[s] = l;
+      scaled[l] -= 1. - scaled[s];
+      if (scaled[l] < 1.) {
+        large.pop_back();
+        small.push_back(l);
+      }
+    }
+    // Whatever is left is 1 up to rounding, and keeps m_prob = 1
+  }
+
+  std::size_t AliasTable::sample() const {
+    return sample(G4UniformRand());
+  }
+
+  std::size_t AliasTable::sample(G4double u) const {
+    auto const n = m_prob.size();
+    auto const column = u*n;
+    auto i = static_cast<std::size_t>(column);
+    if (i >= n) {
+      i = n - 1;
+    }
+    return column - i < m_prob[i] ? i : m_alias[i];
+  }
+
+  std::size_t AliasTable::size() const {
+    return m_prob.size();
+  }
+
+  bool AliasTable::empty() const {
+    return m_prob.empty();
+  }
+}
@@ -0,0 +1,246 @@
+#include "columnarwriter.hpp"
+#include "G4SystemOfUnits.hh"
+#include "stringtable.hpp"
+#include <cstring>
+
+namespace ne697 {
+  namespace {
+    char const magic[8] = {'N', 'E', '6', '9', '7', 'C', 'O', 'L'};
+    // 2 added the weight column
+    std::uint32_t const version = 2;
+
+    struct ColumnInfo {
+      char const* name;
+      char type;
+      std::size_t size;
+    };
+    // Same names (and units) as the hits.csv header
+    ColumnInfo const schema[] = {
+      {"eventID", 'i', 4}, {"trackID", 'i', 4}, {"parentID", 'i', 4},
+      {"particle", 'u', 4}, {"creator_process", 'u', 4}, {"volume", 'u', 4},
+      {"x[cm]", 'd', 8}, {"y[cm]", 'd', 8}, {"z[cm]", 'd', 8},
+      {"energy_dep[keV]", 'f', 4}, {"time[ns]", 'd', 8}, {"weight", 'f', 4}
+    };
+
+    // Values are written in native byte order, which is little-endian on
+    // every machine we run on
+    template<typename T> void write_pod(std::ostream& out, T value) {
+      out.write(reinterpret_cast<char const*>(&value), sizeof(T));
+      return;
+    }
+
+    template<typename T> T read_pod(std::istream& in) {
+      T value{};
+      in.read(reinterpret_cast<char*>(&value), sizeof(T));
+      return value;
+    }
+  }
+
+  ColumnarWriter::ColumnarWriter(G4String const& path):
+    HitWriter(path),
+    m_file(path, std::ios::binary),
+    m_rows(0),
+    m_rowGroups()
+  {
+    if (!m_file) {
+      G4cerr << "Could not open " << m_path << " for writing!" << G4endl;
+    }
+    m_file.write(magic, sizeof(magic));
+    write_pod<std::uint32_t>(m_file, version);
+    write_pod<std::uint32_t>(m_file, 0);
+    for (int i = 0; i < n_columns; ++i) {
+      m_columns[i].reserve(row_group_size*schema[i].size);
+    }
+  }
+
+  ColumnarWriter::~ColumnarWriter() {
+    close();
+  }
+
+  void ColumnarWriter::write(Hit const& hit) {
+    put<std::int32_t>(EventID, hit.getEventID());
+    put<std::int32_t>(TrackID, hit.getTrackID());
+    put<std::int32_t>(ParentID, hit.getParentID());
+    put<std::uint32_t>(Particle, encode(Particle, hit.getParticleID()));
+    put<std::uint32_t>(Process, encode(Process, hit.getProcessID()));
+    put<std::uint32_t>(Volume, encode(Volume, hit.getVolumeID()));
+    put<double>(X, hit.getPosition().getX() / cm);
+    put<double>(Y, hit.getPosition().getY() / cm);
+    put<double>(Z, hit.getPosition().getZ() / cm);
+    put<float>(Energy, hit.getEnergy() / keV);
+    put<double>(Time, hit.getTime() / ns);
+    put<float>(Weight, hit.getWeight());
+    ++m_count;
+    if (++m_rows == row_group_size) {
+      flush_row_group();
+    }
+    return;
+  }
+
+  void ColumnarWriter::append(HitPart const& part) {
+    std::ifstream in_file(part.path, std::ios::binary);
+    char tail[8];
+    in_file.seekg(-16, std::ios::end);
+    auto footer = read_pod<std::uint64_t>(in_file);
+    in_file.read(tail, sizeof(tail));
+    if (!in_file || std::memcmp(tail, magic, sizeof(magic)) != 0) {
+      G4cerr << "Skipping " << part.path << ": not a columnar hit file"
+        << G4endl;
+      return;
+    }
+    in_file.seekg(footer);
+    if (read_pod<std::uint32_t>(in_file) != n_columns) {
+      G4cerr << "Skipping " << part.path << ": column count mismatch" << G4endl;
+      return;
+    }
+    // The part has its own dictionaries, so translate its ids into ours
+    std::vector<std::uint32_t> remap[n_columns];
+    for (int i = 0; i < n_columns; ++i) {
+      auto type = read_pod<char>(in_file);
+      std::string name(read_pod<std::uint16_t>(in_file), '\0');
+      in_file.read(&name[0], name.size());
+      if (type != 'u') {
+        continue;
+      }
+      auto nentries = read_pod<std::uint32_t>(in_file);
+      for (std::uint32_t j = 0; j < nentries; ++j) {
+        std::string value(read_pod<std::uint32_t>(in_file), '\0');
+        in_file.read(&value[0], value.size());
+        remap[i].push_back(encode(Column(i), value));
+      }
+    }
+    std::vector<RowGroup> groups(read_pod<std::uint64_t>(in_file));
+    for (auto& group : groups) {
+      group.rows = read_pod<std::uint64_t>(in_file);
+      for (int i = 0; i < n_columns; ++i) {
+        group.offsets[i] = read_pod<std::uint64_t>(in_file);
+      }
+    }
+
+    // Keep our own buffered rows in front of the appended ones
+    flush_row_group();
+    std::vector<char> chunk;
+    for (auto const& group : groups) {
+      RowGroup out_group;
+      out_group.rows = group.rows;
+      for (int i = 0; i < n_columns; ++i) {
+        chunk.resize(group.rows*schema[i].size);
+        in_file.seekg(group.offsets[i]);
+        in_file.read(chunk.data(), chunk.size());
+        if (schema[i].type == 'u') {
+          auto ids = reinterpret_cast<std::uint32_t*>(chunk.data());
+          for (std::size_t j = 0; j < group.rows; ++j) {
+            ids[j] = remap[i][ids[j]];
+          }
+        }
+        out_group.offsets[i] = write_chunk(chunk.data(), chunk.size());
+      }
+      m_rowGroups.push_back(out_group);
+      m_count += group.rows;
+    }
+    return;
+  }
+
+  void ColumnarWriter::close() {
+    if (m_file.is_open()) {
+      flush_row_group();
+      write_footer();
+      m_file.close();
+    }
+    return;
+  }
+
+  std::size_t ColumnarWriter::tell() {
+    // Buffered rows only land in the file once their row group is written
+    flush_row_group();
+    return m_file.tellp();
+  }
+
+  template<typename T> void ColumnarWriter::put(Column column, T value) {
+    auto& data = m_columns[column];
+    auto size = data.size();
+    data.resize(size + sizeof(T));
+    std::memcpy(data.data() + size, &value, sizeof(T));
+    return;
+  }
+
+  std::uint32_t ColumnarWriter::encode(Column column,
+      std::string const& value) {
+    auto& dict = m_dicts[column];
+    auto found = dict.ids.find(value);
+    if (found != dict.ids.end()) {
+      return found->second;
+    }
+    std::uint32_t id = dict.values.size();
+    dict.ids.emplace(value, id);
+    dict.values.push_back(value);
+    return id;
+  }
+
+  std::uint32_t ColumnarWriter::encode(Column column, G4int id) {
+    auto& table_ids = m_tableIDs[column];
+    if ((std::size_t)id >= table_ids.size()) {
+      table_ids.resize(StringTable::size(), -1);
+    }
+    if (table_ids[id] < 0) {
+      table_ids[id] = encode(column, StringTable::lookup(id));
+    }
+    return table_ids[id];
+  }
+
+  void ColumnarWriter::flush_row_group() {
+    if (m_rows == 0) {
+      return;
+    }
+    RowGroup group;
+    group.rows = m_rows;
+    for (int i = 0; i < n_columns; ++i) {
+      group.offsets[i] = write_chunk(m_columns[i].data(), m_columns[i].size());
+      m_columns[i].clear();
+    }
+    m_rowGroups.push_back(group);
+    m_rows = 0;
+    return;
+  }
+
+  std::uint64_t ColumnarWriter::write_chunk(char const* data,
+      std::size_t size) {
+    static char const padding[8] = {0};
+    std::uint64_t offset = m_file.tellp();
+    if (offset % 8 != 0) {
+      m_file.write(padding, 8 - offset % 8);
+      offset += 8 - offset % 8;
+    }
+    m_file.write(data, size);
+    return offset;
+  }
+
+  void ColumnarWriter::write_footer() {
+    std::uint64_t footer = m_file.tellp();
+    write_pod<std::uint32_t>(m_file, n_columns);
+    for (int i = 0; i < n_columns; ++i) {
+      std::string name(schema[i].name);
+      write_pod<char>(m_file, schema[i].type);
+      write_pod<std::uint16_t>(m_file, name.size());
+      m_file.write(name.data(), name.size());
+      if (schema[i].type != 'u') {
+        continue;
+      }
+      write_pod<std::uint32_t>(m_file, m_dicts[i].values.size());
+      for (auto const& value : m_dicts[i].values) {
+        write_pod<std::uint32_t>(m_file, value.size());
+        m_file.write(value.data(), value.size());
+      }
+    }
+    write_pod<std::uint64_t>(m_file, m_rowGroups.size());
+    for (auto const& group : m_rowGroups) {
+      write_pod<std::uint64_t>(m_file, group.rows);
+      for (int i = 0; i < n_columns; ++i) {
+        write_pod<std::uint64_t>(m_file, group.offsets[i]);
+      }
+    }
+    write_pod<std::uint64_t>(m_file, footer);
+    m_file.write(magic, sizeof(magic));
+    return;
+  }
+}
@@ -0,0 +1,72 @@
+#include "csvwriter.hpp"
+#include "G4SystemOfUnits.hh"
+
+namespace ne697 {
+  CsvWriter::CsvWriter(G4String const& path, bool header):
+    HitWriter(path),
+    m_buffer(buffer_size),
+    m_file()
+  {
+    // The buffer has to be installed before the file is opened, otherwise
+    // the stream ignores it
+    m_file.rdbuf()->pubsetbuf(m_buffer.data(), m_buffer.size());
+    m_file.open(m_path, std::ios::binary);
+    if (!m_file) {
+      G4cerr << "Could not open " << m_path << " for writing!" << G4endl;
+    }
+    if (header) {
+      write_header(m_file);
+    }
+  }
+
+  CsvWriter::~CsvWriter() {
+    close();
+  }
+
+  void CsvWriter::write(Hit const& hit) {
+    m_file << hit.getEventID() << ",";
+    m_file << hit.getTrackID() << ",";
+    m_file << hit.getParentID() << ",";
+    m_file << hit.getParticle() << ",";
+    m_file << hit.getProcess() << ",";
+    m_file << hit.getVolume() << ",";
+    // This is where we take our units back out - the number will be in
+    // whatever units we divide by
+    m_file << hit.getPosition().getX() / cm << ",";
+    m_file << hit.getPosition().getY() / cm << ",";
+    m_file << hit.getPosition().getZ() / cm << ",";
+    m_file << hit.getEnergy() / keV << ",";
+    m_file << hit.getTime() / ns << ",";
+    // No std::endl here: flushing every line defeats the buffer
+    m_file << hit.getWeight() << "\n";
+    ++m_count;
+    return;
+  }
+
+  void CsvWriter::append(HitPart const& part) {
+    // Streaming an empty rdbuf() sets failbit on m_file, so skip those
+    if (part.count > 0) {
+      std::ifstream in_file(part.path, std::ios::binary);
+      m_file << in_file.rdbuf();
+      m_count += part.count;
+    }
+    return;
+  }
+
+  void CsvWriter::close() {
+    if (m_file.is_open()) {
+      m_file.close();
+    }
+    return;
+  }
+
+  std::size_t CsvWriter::tell() {
+    return m_file.tellp();
+  }
+
+  void CsvWriter::write_header(std::ostream& out) {
+    out << "eventID,trackID,parentID,particle,creator_process,volume,";
+    out << "x[cm],y[cm],z[cm],energy_dep[keV],time[ns],weight\n";
+    return;
+  }
+}
@@ -12,17 +12,29 @@
 #include "materialmessenger.hpp"
 #include "G4TessellatedSolid.hh"
 #include "CADMesh.hh"
+#include "primitivefit.hpp"
+#include "geometryparameters.hpp"
+#include "G4UnitsTable.hh"
+#include "G4RunManager.hh"
+#include "G4StateManager.hh"
 
 
 namespace ne697 {
   DetectorConstruction::DetectorConstruction():
     G4VUserDetectorConstruction(),
     m_trackingVols(),
+    m_worldSolid(nullptr),
+    m_detLog(nullptr),
+    m_detPhys(nullptr),
     m_detThickness(5.*cm),
     m_detRadius(50.*cm),
     m_detMaterial("G4_AIR"),
     m_worldMaterial("G4_SODIUM_IODIDE"),
-    m_detGeometry("Cylinder")
+    m_detGeometry("Cylinder"),
+    m_meshTolerance(0.),
+    m_fitTolerance(0.),
+    m_meshBackend("tessellated"),
+    m_tetQuality(2.)
     {
       G4cout << "Creating DetectorConstruction" << G4endl;
       m_gmessenger = new GeometryMessenger(this);
@@ -37,7 +49,11 @@ namespace ne697 {
     }
 
   G4PVPlacement* DetectorConstruction::Construct() {
+    // Construct() runs again after reinitialize(), and the old volumes are
+    // gone by then
+    m_trackingVols.clear();
     auto world_solid = new G4Box("world_solid", m_detRadius*2., m_detRadius*2., m_detRadius*2.);
+    m_worldSolid = world_solid;
     auto nist = G4NistManager::Instance();
     // auto world_mat = nist->FindOrBuildMaterial("G4_AIR");
     // auto world_mat = liq_Ar;
@@ -63,26 +79,30 @@ namespace ne697 {
     );
 
 
-    //Create PEN shape
-    //Import CAD Shape
-    auto PEN_mesh = CADMesh::TessellatedMesh::FromSTL("./Capsule.stl");
-
     //Define PEN material
     auto PEN_mat = nist->FindOrBuildMaterial("NE697_PEN");
     //Logic for PEN plate
 
     auto rotation = new G4RotationMatrix();
     rotation->rotateX(90*deg);
+    G4ThreeVector PEN_position(0*cm, 0*cm, -5*cm);
 
-    auto PEN_logic = new G4LogicalVolume(PEN_mesh->GetSolid(),PEN_mat,"PEN_logic");
-    new G4PVPlacement( rotation,
-			G4ThreeVector(0*cm,0*cm,-5*cm),
-			PEN_logic,
-			"PEN_phys",
-			world_log,
-			false,
-			0,
-			true);
+    // G4PVPlacement wants the inverse (frame) rotation, the assembly the
+    // rotation of the object itself
+    if (m_meshBackend != "tetrahedral" || !place_pen_tets(world_log, PEN_mat,
+          G4Transform3D(rotation->inverse(), PEN_position))) {
+      auto PEN_logic = new G4LogicalVolume(build_pen_solid(),PEN_mat,"PEN_logic");
+      new G4PVPlacement(
+        rotation,
+        PEN_position,
+        PEN_logic,
+        "PEN_phys",
+        world_log,
+        false,
+        0,
+        true
+      );
+    }
 
     auto HPGE_mat = nist->FindOrBuildMaterial("G4_Ge");
 
@@ -108,56 +128,120 @@ namespace ne697 {
 
     auto det_mat = nist->FindOrBuildMaterial(m_detMaterial);
 
-    if(m_detGeometry == "Cylinder")
-    {
-      auto det_solidCylinder = new G4Tubs("det_solidCylinder",
-                                           m_detRadius,
-                                           m_detRadius+0.5*cm,
-                                           m_detRadius,
-                                           0.0*rad,CLHEP::twopi*rad);
-
-      auto det_log = new G4LogicalVolume(det_solidCylinder, det_mat, "det_log");
-      m_trackingVols.push_back(det_log);
-      new G4PVPlacement(
-        nullptr,
-        G4ThreeVector(0*cm, 0.*cm, 0*cm),
-        det_log,
-        "det_phys",
-        world_log,
-        false,
-        0,
-        true
-      );
+    m_detLog = new G4LogicalVolume(build_det_solid(), det_mat, "det_log");
+    m_trackingVols.push_back(m_detLog);
+    m_detPhys = new G4PVPlacement(
+      nullptr,
+      G4ThreeVector(0*cm, 0.*cm, 0*cm),
+      m_detLog,
+      "det_phys",
+      world_log,
+      false,
+      0,
+      true
+    );
+
+    publish_parameters();
+    return world_phys;
+  }
+
+  void DetectorConstruction::publish_parameters() const {
+    GeometryParameters parameters;
+    parameters.det_radius = m_detRadius;
+    parameters.det_thickness = m_detThickness;
+    parameters.det_geometry = m_detGeometry;
+    parameters.det_material = m_detMaterial;
+    parameters.world_material = m_worldMaterial;
+    parameters.world_half_length = m_worldSolid->GetXHalfLength();
+    parameters.version = 0;
+    GeometryParameters::publish(parameters);
+    return;
+  }
+
+  G4VSolid* DetectorConstruction::build_det_solid() const {
+    if (m_detGeometry == "Cylinder") {
+      return new G4Tubs("det_solidCylinder",
+                        m_detRadius,
+                        m_detRadius+0.5*cm,
+                        m_detRadius,
+                        0.0*rad,CLHEP::twopi*rad);
     }
-    else
-    {
-      auto det_solidSphere = new G4Sphere("det_solidSphere",
-                                    m_detRadius,
-                                    m_detRadius+0.5*cm,
-                                    0.0*rad, CLHEP::twopi*rad,
-                                    0.0*rad, CLHEP::pi*rad);
-
-      auto det_log = new G4LogicalVolume(det_solidSphere, det_mat, "det_log");
-      m_trackingVols.push_back(det_log);
-      new G4PVPlacement(
-        nullptr,
-        G4ThreeVector(0, 0.*cm, 0*cm),
-        det_log,
-        "det_phys",
-        world_log,
-        false,
-        0,
-        true
-      );
+    return new G4Sphere("det_solidSphere",
+                        m_detRadius,
+                        m_detRadius+0.5*cm,
+                        0.0*rad, CLHEP::twopi*rad,
+                        0.0*rad, CLHEP::pi*rad);
+  }
+
+  G4VSolid* DetectorConstruction::build_pen_solid() {
+    //Create PEN shape
+    //Import CAD Shape
+    auto PEN_mesh = CADMesh::TessellatedMesh::FromSTL("./Capsule.stl");
+    if (m_fitTolerance > 0.) {
+      // Analytic solids navigate much faster than facets, so use one if
+      // the mesh is really a simple shape
+      auto mesh = PEN_mesh->GetReader()->GetMesh();
+      std::vector<G4ThreeVector> points;
+      for (auto const& point : mesh->GetPoints()) {
+        points.push_back(point*PEN_mesh->GetScale() + PEN_mesh->GetOffset());
+      }
+      PrimitiveFit fit(points, mesh->GetIndices());
+      auto PEN_solid = fit.build_solid("PEN_solid", m_fitTolerance);
+      G4cout << "PEN mesh best matches a " << fit.get_shape()
+        << " to within " << G4BestUnit(fit.get_error(), "Length")
+        << (PEN_solid ? ", using it" : ", keeping the mesh") << G4endl;
+      if (PEN_solid) {
+        return PEN_solid;
+      }
     }
+    PEN_mesh->SetDecimationTolerance(m_meshTolerance);
+    auto PEN_solid = PEN_mesh->GetTessellatedSolid();
+    if (m_meshTolerance > 0.) {
+      G4cout << "PEN mesh simplified to " << PEN_solid->GetNumberOfFacets()
+        << " facets" << G4endl;
+    }
+    return PEN_solid;
+  }
 
-    return world_phys;
+  bool DetectorConstruction::place_pen_tets(G4LogicalVolume* world_log,
+      G4Material* material, G4Transform3D placement) {
+#ifdef USE_CADMESH_TETGEN
+    auto PEN_mesh = CADMesh::TetrahedralMesh::FromSTL("./Capsule.stl");
+    PEN_mesh->SetMaterial(material);
+    PEN_mesh->SetQuality(m_tetQuality);
+    auto assembly = PEN_mesh->GetAssembly();
+    // No overlap check: each tet would be checked against every tet
+    // already in the world, which is O(N^2) and swamps the timing the
+    // backends are compared on. The HPGe and detector placements below
+    // still check themselves against the tets
+    assembly->MakeImprint(world_log, placement, 0, false);
+    G4cout << "PEN mesh placed as "
+      << PEN_mesh->GetTetgenOutput()->numberoftetrahedra << " tetrahedra"
+      << G4endl;
+    return true;
+#else
+    (void)world_log;
+    (void)material;
+    (void)placement;
+    G4cerr << "Error: Built without TetGen (configure with -DUSE_TETGEN=ON), "
+      << "using the tessellated PEN mesh" << G4endl;
+    return false;
+#endif
   }
 
   void DetectorConstruction::ConstructSDandField() {
     // We will ask for "world_sd_hits" later in Run::RecordEvent()
-    auto sd = new SensitiveDetector("world_sd");
-    G4SDManager::GetSDMpointer()->AddNewDetector(sd);
+    // After a reinitialize() this thread already has the SD: keep it, and
+    // its /ne697/sd/ settings, and just point it at the new volumes
+    auto sd_manager = G4SDManager::GetSDMpointer();
+    auto sd = dynamic_cast<SensitiveDetector*>(
+        sd_manager->FindSensitiveDetector("world_sd", false));
+    if (sd) {
+      sd->set_tracked_volumes(m_trackingVols);
+    } else {
+      sd = new SensitiveDetector("world_sd", m_trackingVols);
+      sd_manager->AddNewDetector(sd);
+    }
     // Connect the sensitive detector to all of the logical volumes on the list
     for (auto& log : m_trackingVols) {
       SetSensitiveDetector(log, sd);
@@ -165,6 +249,58 @@ namespace ne697 {
     return;
   }
 
+  void DetectorConstruction::reinitialize() {
+    // Before /run/initialize, Construct() hasn't run yet and picks the new
+    // values up anyway
+    if (G4StateManager::GetStateManager()->GetCurrentState() ==
+        G4State_PreInit) {
+      return;
+    }
+    // Empties the volume and solid stores, so Construct() starts from
+    // nothing; this also reaches the workers. Materials stay, and Geant4
+    // only builds physics tables for material-cut couples it hasn't seen
+    m_worldSolid = nullptr;
+    m_detLog = nullptr;
+    m_detPhys = nullptr;
+    G4RunManager::GetRunManager()->ReinitializeGeometry(true);
+    return;
+  }
+
+  void DetectorConstruction::update_detector() {
+    // Not built yet, or waiting for a rebuild: Construct() uses the new
+    // values either way
+    if (!m_detLog) {
+      return;
+    }
+    // The logical volume's solid pointer is per thread, so switching
+    // between cylinder and sphere needs the workers to rebuild too. The
+    // solids themselves are shared, so resizing them reaches every thread
+    auto tubs = dynamic_cast<G4Tubs*>(m_detLog->GetSolid());
+    auto sphere = dynamic_cast<G4Sphere*>(m_detLog->GetSolid());
+    if (m_detGeometry == "Cylinder" ? !tubs : !sphere) {
+      reinitialize();
+      return;
+    }
+    m_worldSolid->SetXHalfLength(m_detRadius*2.);
+    m_worldSolid->SetYHalfLength(m_detRadius*2.);
+    m_worldSolid->SetZHalfLength(m_detRadius*2.);
+    if (tubs) {
+      tubs->SetOuterRadius(m_detRadius+0.5*cm);
+      tubs->SetInnerRadius(m_detRadius);
+      tubs->SetZHalfLength(m_detRadius);
+    } else {
+      sphere->SetOuterRadius(m_detRadius+0.5*cm);
+      sphere->SetInnerRadius(m_detRadius);
+    }
+    // The PEN and HPGe volumes don't scale with the shell, so a small
+    // enough radius cuts through them
+    m_detPhys->CheckOverlaps();
+    publish_parameters();
+    // Reoptimises the navigation voxels at the start of the next run
+    G4RunManager::GetRunManager()->GeometryHasBeenModified();
+    return;
+  }
+
   void DetectorConstruction::build_materials() {
 
 
@@ -324,4 +460,40 @@ namespace ne697 {
     m_detGeometry = geometry;
     return;
   }
+
+  G4double const& DetectorConstruction::get_mesh_tolerance() const {
+    return m_meshTolerance;
+  }
+
+  void DetectorConstruction::set_mesh_tolerance(G4double const& tolerance) {
+    m_meshTolerance = tolerance;
+    return;
+  }
+
+  G4double const& DetectorConstruction::get_fit_tolerance() const {
+    return m_fitTolerance;
+  }
+
+  void DetectorConstruction::set_fit_tolerance(G4double const& tolerance) {
+    m_fitTolerance = tolerance;
+    return;
+  }
+
+  G4String const& DetectorConstruction::get_mesh_backend() const {
+    return m_meshBackend;
+  }
+
+  void DetectorConstruction::set_mesh_backend(G4String const& backend) {
+    m_meshBackend = backend;
+    return;
+  }
+
+  G4double const& DetectorConstruction::get_tet_quality() const {
+    return m_tetQuality;
+  }
+
+  void DetectorConstruction::set_tet_quality(G4double const& quality) {
+    m_tetQuality = quality;
+    return;
+  }
 }
@@ -3,10 +3,23 @@
 #include "G4Event.hh"
 #include "G4RunManager.hh"
 #include "G4Run.hh"
+#include "run.hpp"
+#include <time.h>
 
 namespace ne697 {
+  namespace {
+    // CPU time used by the calling thread, in ms. Unlike std::clock() this
+    // doesn't count the other worker threads
+    G4double thread_cpu_time() {
+      timespec now;
+      clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+      return now.tv_sec*1e3 + now.tv_nsec*1e-6;
+    }
+  }
+
   EventAction::EventAction():
-    G4UserEventAction()
+    G4UserEventAction(),
+    m_eventStart(0.)
     {
       G4cout << "Creating EventAction" << G4endl;
     }
@@ -15,9 +28,18 @@ namespace ne697 {
     G4cout << "Deleting EventAction" << G4endl;
   }
 
+  void EventAction::BeginOfEventAction(G4Event const*) {
+    m_eventStart = thread_cpu_time();
+    return;
+  }
+
   void EventAction::EndOfEventAction(G4Event const* event) {
     auto run_man = G4RunManager::GetRunManager();
     auto run = dynamic_cast<G4Run*>(run_man->GetNonConstCurrentRun());
+    auto our_run = dynamic_cast<Run*>(run);
+    if (our_run) {
+      our_run->add_event_time(thread_cpu_time() - m_eventStart);
+    }
     auto ntotal = run->GetNumberOfEventToBeProcessed();
     auto ievent = event->GetEventID();
     // Report status every 5% or so
@@ -15,14 +15,14 @@ namespace ne697 {
     m_detThicknessCmd->SetGuidance("Set the detector thickness.");
     m_detThicknessCmd->SetParameterName("y", true);
     m_detThicknessCmd->SetDefaultValue(m_dc->get_det_thickness());
-    m_detThicknessCmd->AvailableForStates(G4State_PreInit);
+    m_detThicknessCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
 
     // Set detector length: /ne697/geometry/det_length
     m_detRadiusCmd = new G4UIcmdWithADoubleAndUnit("/ne697/geometry/det_radius", this);
     m_detRadiusCmd->SetGuidance("Set the photon detector radius.");
     m_detRadiusCmd->SetParameterName("r", true);
     m_detRadiusCmd->SetDefaultValue(m_dc->get_det_radius());
-    m_detRadiusCmd->AvailableForStates(G4State_PreInit);
+    m_detRadiusCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
 
     m_detGeometryCmd = new G4UIcmdWithAString("/ne697/geometry/det_geometry", this);
     m_detGeometryCmd->SetGuidance("Select geometry of the photon detector.");
@@ -31,6 +31,42 @@ namespace ne697 {
     m_detGeometryCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
     m_detGeometryCmd->SetDefaultValue(m_dc->get_det_geometry());
 
+    // Simplify the CAD meshes: /ne697/geometry/mesh_tolerance
+    m_meshToleranceCmd = new G4UIcmdWithADoubleAndUnit("/ne697/geometry/mesh_tolerance", this);
+    m_meshToleranceCmd->SetGuidance("Simplify the CAD meshes, moving the surface by at most this much.");
+    m_meshToleranceCmd->SetGuidance("Fewer facets make stepping through the mesh faster; 0 keeps every facet.");
+    m_meshToleranceCmd->SetParameterName("tolerance", true);
+    m_meshToleranceCmd->SetDefaultUnit("mm");
+    m_meshToleranceCmd->SetDefaultValue(m_dc->get_mesh_tolerance());
+    m_meshToleranceCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Swap CAD meshes for analytic solids: /ne697/geometry/fit_tolerance
+    m_fitToleranceCmd = new G4UIcmdWithADoubleAndUnit("/ne697/geometry/fit_tolerance", this);
+    m_fitToleranceCmd->SetGuidance("Replace a CAD mesh with a box, tube, sphere or capsule if its surface is within this distance of one.");
+    m_fitToleranceCmd->SetGuidance("0 always keeps the mesh.");
+    m_fitToleranceCmd->SetParameterName("tolerance", true);
+    m_fitToleranceCmd->SetDefaultUnit("mm");
+    m_fitToleranceCmd->SetDefaultValue(m_dc->get_fit_tolerance());
+    m_fitToleranceCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // How the PEN mesh is navigated: /ne697/geometry/mesh_backend
+    m_meshBackendCmd = new G4UIcmdWithAString("/ne697/geometry/mesh_backend", this);
+    m_meshBackendCmd->SetGuidance("Load the PEN mesh as one tessellated solid or as tetrahedra.");
+    m_meshBackendCmd->SetGuidance("'tetrahedral' needs a build with -DUSE_TETGEN=ON.");
+    m_meshBackendCmd->SetCandidates("tessellated tetrahedral");
+    m_meshBackendCmd->SetDefaultValue(m_dc->get_mesh_backend());
+    m_meshBackendCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // TetGen quality bound: /ne697/geometry/tet_quality
+    m_tetQualityCmd = new G4UIcmdWithADouble("/ne697/geometry/tet_quality", this);
+    m_tetQualityCmd->SetGuidance("Maximum radius-edge ratio of the tetrahedra (TetGen -q).");
+    m_tetQualityCmd->SetGuidance("Smaller is better shaped but more tetrahedra; 0 turns refinement off.");
+    m_tetQualityCmd->SetGuidance("Nonzero values must be at least 1.1, below which TetGen may never finish;");
+    m_tetQualityCmd->SetGuidance("it is only guaranteed to finish from 2 up.");
+    m_tetQualityCmd->SetParameterName("quality", true);
+    m_tetQualityCmd->SetDefaultValue(m_dc->get_tet_quality());
+    m_tetQualityCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
   }
 
   GeometryMessenger::~GeometryMessenger() {
@@ -38,6 +74,10 @@ namespace ne697 {
     delete m_detThicknessCmd;
     delete m_detRadiusCmd;
     delete m_detGeometryCmd;
+    delete m_meshToleranceCmd;
+    delete m_fitToleranceCmd;
+    delete m_meshBackendCmd;
+    delete m_tetQualityCmd;
   }
 
   void GeometryMessenger::SetNewValue(G4UIcommand* cmd, G4String val) {
@@ -46,7 +86,7 @@ namespace ne697 {
       // This is fine too - just being clear above
       //auto parsed_val = m_detSizeCmd->GetNew3VectorValue(val);
       if(parsed_val< 0.0)
-        { G4cerr <<"Error: Thickness must be greater than zero!"<< G4endl; }
+        { G4cerr <<"Error: Thickness must be greater than zero!"<< G4endl; return; }
 
       m_dc->set_det_thickness(parsed_val);
       G4cout << "Detector thickness set to " << G4BestUnit(parsed_val, "Length")
@@ -57,7 +97,7 @@ namespace ne697 {
       // This is fine too - just being clear above
       //auto parsed_val = m_detSizeCmd->GetNew3VectorValue(val);
       if(parsed_val< 0.0)
-        { G4cerr <<"Error: Radius must be greater than zero!"<< G4endl; }
+        { G4cerr <<"Error: Radius must be greater than zero!"<< G4endl; return; }
 
       m_dc->set_det_radius(parsed_val);
       G4cout << "Detector radius set to " << G4BestUnit(parsed_val, "Length")
@@ -67,8 +107,56 @@ namespace ne697 {
       m_dc->set_det_geometry(val);
       G4cout << "Detector geometry set to " << val << G4endl;
     }
+    if (cmd == m_meshToleranceCmd) {
+      G4double parsed_val = m_meshToleranceCmd->GetNewDoubleValue(val);
+      if (parsed_val < 0.) {
+        G4cerr << "Error: Mesh tolerance must not be negative!" << G4endl;
+        return;
+      }
+
+      m_dc->set_mesh_tolerance(parsed_val);
+      G4cout << "Mesh tolerance set to " << G4BestUnit(parsed_val, "Length")
+        << G4endl;
+    }
+    if (cmd == m_fitToleranceCmd) {
+      G4double parsed_val = m_fitToleranceCmd->GetNewDoubleValue(val);
+      if (parsed_val < 0.) {
+        G4cerr << "Error: Fit tolerance must not be negative!" << G4endl;
+        return;
+      }
 
-    // Command didn't match
+      m_dc->set_fit_tolerance(parsed_val);
+      G4cout << "Fit tolerance set to " << G4BestUnit(parsed_val, "Length")
+        << G4endl;
+    }
+    if (cmd == m_meshBackendCmd) {
+      m_dc->set_mesh_backend(val);
+      G4cout << "Mesh backend set to " << val << G4endl;
+    }
+    if (cmd == m_tetQualityCmd) {
+      G4double parsed_val = m_tetQualityCmd->GetNewDoubleValue(val);
+      if (parsed_val < 0.) {
+        G4cerr << "Error: Tet quality must not be negative!" << G4endl;
+        return;
+      }
+      if (parsed_val > 0. && parsed_val < 1.1) {
+        G4cerr << "Error: Tet quality must be 0 or at least 1.1, or TetGen "
+          << "may never finish!" << G4endl;
+        return;
+      }
+
+      m_dc->set_tet_quality(parsed_val);
+      G4cout << "Tet quality set to " << parsed_val << G4endl;
+    }
+
+    if (cmd == m_detThicknessCmd || cmd == m_detRadiusCmd ||
+        cmd == m_detGeometryCmd) {
+      // Only the world box and detector shell depend on these
+      m_dc->update_detector();
+    } else {
+      // The rest change the PEN mesh, which has to be rebuilt from scratch
+      m_dc->reinitialize();
+    }
     return;
   }
 }
@@ -0,0 +1,28 @@
+#include "geometryparameters.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ne697 {
+  namespace {
+    std::atomic<GeometryParameters const*> latest(nullptr);
+    // Owns every snapshot, so readers never see one deleted. Geometry
+    // changes are rare enough that this stays tiny
+    std::vector<std::unique_ptr<GeometryParameters const>> published;
+    std::mutex publish_mutex;
+  }
+
+  GeometryParameters const* GeometryParameters::current() {
+    return latest.load(std::memory_order_acquire);
+  }
+
+  void GeometryParameters::publish(GeometryParameters const& parameters) {
+    std::lock_guard<std::mutex> lock(publish_mutex);
+    auto snapshot = new GeometryParameters(parameters);
+    snapshot->version = published.size() + 1;
+    published.emplace_back(snapshot);
+    latest.store(snapshot, std::memory_order_release);
+    return;
+  }
+}
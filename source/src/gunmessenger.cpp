@@ -1,6 +1,9 @@
 #include "gunmessenger.hpp"
 #include "pga.hpp"
+#include "G4Threading.hh"
 #include "G4UnitsTable.hh"
+#include "G4UIparameter.hh"
+#include <sstream>
 
 namespace ne697 {
   GunMessenger::GunMessenger(PGA* pga):
@@ -15,15 +18,163 @@ namespace ne697 {
     m_gunOffsetCmd->SetGuidance("Set the particle gun height.");
     m_gunOffsetCmd->SetParameterName("y", true);
     m_gunOffsetCmd->SetDefaultValue(m_pga->get_gun_offset());
-    m_gunOffsetCmd->AvailableForStates(G4State_PreInit);
+    m_gunOffsetCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Source positions per batch: /ne697/gun/batch_size
+    m_batchSizeCmd = new G4UIcmdWithAnInteger("/ne697/gun/batch_size", this);
+    m_batchSizeCmd->SetGuidance("Draw this many source positions at a time, per thread.");
+    m_batchSizeCmd->SetGuidance("1 keeps each event reproducible from its own seed in MT mode.");
+    m_batchSizeCmd->SetParameterName("size", true);
+    m_batchSizeCmd->SetRange("size >= 1");
+    m_batchSizeCmd->SetDefaultValue(m_pga->get_batch_size());
+    m_batchSizeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Time the source sampling: /ne697/gun/benchmark
+    m_benchmarkCmd = new G4UIcmdWithAnInteger("/ne697/gun/benchmark", this);
+    m_benchmarkCmd->SetGuidance("Time drawing this many source positions one at a time and in batches.");
+    m_benchmarkCmd->SetGuidance("In MT mode each worker runs it at the start of the next run.");
+    m_benchmarkCmd->SetParameterName("n_events", true);
+    m_benchmarkCmd->SetRange("n_events > 0");
+    m_benchmarkCmd->SetDefaultValue(100000);
+    m_benchmarkCmd->AvailableForStates(G4State_Idle);
+
+    // Where primaries start: /ne697/gun/position_mode
+    m_positionModeCmd = new G4UIcmdWithAString("/ne697/gun/position_mode", this);
+    m_positionModeCmd->SetGuidance("Source position distribution.");
+    m_positionModeCmd->SetGuidance("halfcylinder: the original 50 cm half-cylinder source.");
+    m_positionModeCmd->SetGuidance("point: (0, offset, 0), see /ne697/gun/offset.");
+    m_positionModeCmd->SetGuidance("volume: uniform in source_volume, not counting its daughters.");
+    m_positionModeCmd->SetGuidance("surface: uniform on the surface of source_volume.");
+    m_positionModeCmd->SetParameterName("mode", true);
+    m_positionModeCmd->SetCandidates("halfcylinder point volume surface");
+    m_positionModeCmd->SetDefaultValue(m_pga->get_position_mode());
+    m_positionModeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Source volume: /ne697/gun/source_volume
+    m_sourceVolumeCmd = new G4UIcmdWithAString("/ne697/gun/source_volume", this);
+    m_sourceVolumeCmd->SetGuidance("Physical volume for the volume and surface position modes, e.g. world_phys.");
+    m_sourceVolumeCmd->SetParameterName("name", false);
+    m_sourceVolumeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Primary directions: /ne697/gun/direction_mode
+    m_directionModeCmd = new G4UIcmdWithAString("/ne697/gun/direction_mode", this);
+    m_directionModeCmd->SetGuidance("gun: keep /gun/direction. isotropic: a random direction per primary.");
+    m_directionModeCmd->SetGuidance("biased: isotropic, but bias_fraction of the primaries are aimed into the");
+    m_directionModeCmd->SetGuidance("cone around bias_volume. Each primary carries the weight that makes");
+    m_directionModeCmd->SetGuidance("weighted tallies (the weight column, histograms) match isotropic.");
+    m_directionModeCmd->SetGuidance("Isotope and zero-energy primaries are left isotropic, with weight 1.");
+    m_directionModeCmd->SetParameterName("mode", true);
+    m_directionModeCmd->SetCandidates("gun isotropic biased");
+    m_directionModeCmd->SetDefaultValue(m_pga->get_direction_mode());
+    m_directionModeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Target of the biased mode: /ne697/gun/bias_volume
+    m_biasVolumeCmd = new G4UIcmdWithAString("/ne697/gun/bias_volume", this);
+    m_biasVolumeCmd->SetGuidance("Physical volume the biased direction mode aims at.");
+    m_biasVolumeCmd->SetParameterName("name", true);
+    m_biasVolumeCmd->SetDefaultValue(m_pga->get_bias_volume());
+    m_biasVolumeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // How hard to bias: /ne697/gun/bias_fraction
+    m_biasFractionCmd = new G4UIcmdWithADouble("/ne697/gun/bias_fraction", this);
+    m_biasFractionCmd->SetGuidance("Fraction of biased primaries aimed at bias_volume; the rest are isotropic.");
+    m_biasFractionCmd->SetGuidance("Must stay below 1 so directions that miss it can still happen.");
+    m_biasFractionCmd->SetParameterName("fraction", true);
+    m_biasFractionCmd->SetRange("fraction >= 0. && fraction < 1.");
+    m_biasFractionCmd->SetDefaultValue(m_pga->get_bias_fraction());
+    m_biasFractionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Energy spectrum: /ne697/gun/spectrum_line
+    m_spectrumLineCmd = new G4UIcommand("/ne697/gun/spectrum_line", this);
+    m_spectrumLineCmd->SetGuidance("Add a line to the energy spectrum, e.g. 1524.6 keV 18.1.");
+    m_spectrumLineCmd->SetGuidance("While there are lines, each primary's energy is drawn from them");
+    m_spectrumLineCmd->SetGuidance("in proportion to their weights, instead of using /gun/energy.");
+    auto param = new G4UIparameter("energy", 'd', false);
+    param->SetParameterRange("energy > 0.");
+    m_spectrumLineCmd->SetParameter(param);
+    param = new G4UIparameter("unit", 's', false);
+    m_spectrumLineCmd->SetParameter(param);
+    param = new G4UIparameter("weight", 'd', true);
+    param->SetParameterRange("weight > 0.");
+    param->SetDefaultValue(1.);
+    m_spectrumLineCmd->SetParameter(param);
+    m_spectrumLineCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Back to /gun/energy: /ne697/gun/spectrum_clear
+    m_spectrumClearCmd = new G4UIcmdWithoutParameter("/ne697/gun/spectrum_clear", this);
+    m_spectrumClearCmd->SetGuidance("Remove every spectrum line, going back to the /gun/energy from before");
+    m_spectrumClearCmd->SetGuidance("the spectrum took over.");
+    m_spectrumClearCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Tabulated spectrum: /ne697/gun/spectrum_file
+    m_spectrumFileCmd = new G4UIcmdWithAString("/ne697/gun/spectrum_file", this);
+    m_spectrumFileCmd->SetGuidance("Add the lines and continuum bins in a text file to the spectrum.");
+    m_spectrumFileCmd->SetGuidance("One entry per line, '#' starts a comment:");
+    m_spectrumFileCmd->SetGuidance("  line <energy> <unit> <weight>");
+    m_spectrumFileCmd->SetGuidance("  continuum <low> <high> <unit> <weight>");
+    m_spectrumFileCmd->SetGuidance("Continuum bins are flat between low and high.");
+    m_spectrumFileCmd->SetParameterName("path", false);
+    m_spectrumFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Check the spectrum sampling: /ne697/gun/spectrum_test
+    m_spectrumTestCmd = new G4UIcmdWithAnInteger("/ne697/gun/spectrum_test", this);
+    m_spectrumTestCmd->SetGuidance("Draw this many energies, print a chi-square test against the weights");
+    m_spectrumTestCmd->SetGuidance("and the time per draw. In MT mode each worker runs it at the start");
+    m_spectrumTestCmd->SetGuidance("of the next run.");
+    m_spectrumTestCmd->SetParameterName("n_samples", true);
+    m_spectrumTestCmd->SetRange("n_samples > 0");
+    m_spectrumTestCmd->SetDefaultValue(1000000);
+    m_spectrumTestCmd->AvailableForStates(G4State_Idle);
+
+    // Background isotopes: /ne697/gun/isotope
+    m_isotopeCmd = new G4UIcommand("/ne697/gun/isotope", this);
+    m_isotopeCmd->SetGuidance("Add an isotope to fire at rest, e.g. 18 42 for Ar-42.");
+    m_isotopeCmd->SetGuidance("Each primary is one of the isotopes, picked in proportion to their");
+    m_isotopeCmd->SetGuidance("weights (activities); radioactive decay follows the chain from there.");
+    param = new G4UIparameter("Z", 'i', false);
+    param->SetParameterRange("Z > 0");
+    m_isotopeCmd->SetParameter(param);
+    param = new G4UIparameter("A", 'i', false);
+    param->SetParameterRange("A > 0");
+    m_isotopeCmd->SetParameter(param);
+    param = new G4UIparameter("weight", 'd', true);
+    param->SetParameterRange("weight > 0.");
+    param->SetDefaultValue(1.);
+    m_isotopeCmd->SetParameter(param);
+    m_isotopeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Back to the /gun/ particle: /ne697/gun/isotope_clear
+    m_isotopeClearCmd = new G4UIcmdWithoutParameter("/ne697/gun/isotope_clear", this);
+    m_isotopeClearCmd->SetGuidance("Remove every isotope, going back to the /gun/particle and /gun/energy");
+    m_isotopeClearCmd->SetGuidance("from before the isotopes took over.");
+    m_isotopeClearCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
   }
 
   GunMessenger::~GunMessenger() {
     delete m_directory;
     delete m_gunOffsetCmd;
+    delete m_batchSizeCmd;
+    delete m_benchmarkCmd;
+    delete m_positionModeCmd;
+    delete m_sourceVolumeCmd;
+    delete m_directionModeCmd;
+    delete m_biasVolumeCmd;
+    delete m_biasFractionCmd;
+    delete m_spectrumLineCmd;
+    delete m_spectrumClearCmd;
+    delete m_spectrumFileCmd;
+    delete m_spectrumTestCmd;
+    delete m_isotopeCmd;
+    delete m_isotopeClearCmd;
   }
 
   void GunMessenger::SetNewValue(G4UIcommand* cmd, G4String val) {
+    // The master's copy (see WorkerCommands) is only there to check the
+    // command; the workers' copies act on it
+    if (G4Threading::IsMultithreadedApplication() &&
+        G4Threading::IsMasterThread()) {
+      return;
+    }
     if (cmd == m_gunOffsetCmd) {
       G4double parsed_val = m_gunOffsetCmd->GetNewDoubleValue(val);
       // This is fine too - just being clear above
@@ -35,6 +186,81 @@ namespace ne697 {
       G4cout << "Particle gun height set to: " << G4BestUnit(parsed_val, "Length")
         << G4endl;
     }
+    if (cmd == m_batchSizeCmd) {
+      G4int parsed_val = m_batchSizeCmd->GetNewIntValue(val);
+      m_pga->set_batch_size(parsed_val);
+      G4cout << "Source batch size set to " << parsed_val << G4endl;
+    }
+    if (cmd == m_benchmarkCmd) {
+      m_pga->benchmark(m_benchmarkCmd->GetNewIntValue(val));
+    }
+    if (cmd == m_positionModeCmd) {
+      m_pga->set_position_mode(val);
+      G4cout << "Source position mode set to " << val << G4endl;
+    }
+    if (cmd == m_sourceVolumeCmd) {
+      m_pga->set_source_volume(val);
+      G4cout << "Source volume set to " << val << G4endl;
+    }
+    if (cmd == m_directionModeCmd) {
+      m_pga->set_direction_mode(val);
+      G4cout << "Source direction mode set to " << val << G4endl;
+    }
+    if (cmd == m_biasVolumeCmd) {
+      m_pga->set_bias_volume(val);
+      G4cout << "Bias volume set to " << val << G4endl;
+    }
+    if (cmd == m_biasFractionCmd) {
+      G4double parsed_val = m_biasFractionCmd->GetNewDoubleValue(val);
+      m_pga->set_bias_fraction(parsed_val);
+      G4cout << "Bias fraction set to " << parsed_val << G4endl;
+    }
+    if (cmd == m_spectrumLineCmd) {
+      std::istringstream val_stream(val);
+      G4double energy, weight;
+      G4String unit;
+      val_stream >> energy >> unit >> weight;
+      if (G4UnitDefinition::GetCategory(unit) != "Energy") {
+        G4cerr << "Error: " << unit << " isn't an energy unit" << G4endl;
+        return;
+      }
+      energy *= G4UIcommand::ValueOf(unit);
+      m_pga->add_spectrum_line(energy, weight);
+      G4cout << "Added spectrum line at " << G4BestUnit(energy, "Energy")
+        << " with weight " << weight << " (" << m_pga->get_spectrum_size()
+        << " lines)" << G4endl;
+    }
+    if (cmd == m_spectrumFileCmd) {
+      if (m_pga->load_spectrum(val)) {
+        G4cout << "Loaded spectrum file " << val << " ("
+          << m_pga->get_spectrum_size() << " entries)" << G4endl;
+      }
+    }
+    if (cmd == m_spectrumTestCmd) {
+      m_pga->test_spectrum(m_spectrumTestCmd->GetNewIntValue(val));
+    }
+    if (cmd == m_spectrumClearCmd) {
+      m_pga->clear_spectrum();
+      G4cout << "Spectrum cleared" << G4endl;
+    }
+    if (cmd == m_isotopeCmd) {
+      std::istringstream val_stream(val);
+      G4int z, a;
+      G4double weight;
+      val_stream >> z >> a >> weight;
+      if (a < z) {
+        G4cerr << "Error: A must be at least Z" << G4endl;
+        return;
+      }
+      m_pga->add_isotope(z, a, weight);
+      G4cout << "Added isotope Z = " << z << ", A = " << a << " with weight "
+        << weight << " (" << m_pga->get_isotope_count() << " isotopes)"
+        << G4endl;
+    }
+    if (cmd == m_isotopeClearCmd) {
+      m_pga->clear_isotopes();
+      G4cout << "Isotopes cleared" << G4endl;
+    }
 
     // Command didn't match
     return;
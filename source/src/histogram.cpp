@@ -0,0 +1,88 @@
+#include "histogram.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace ne697 {
+  Histogram::Histogram(G4int nbins, G4double min, G4double max):
+    m_nbins(nbins > 0 ? nbins : 0),
+    m_min(min),
+    m_max(max),
+    m_scale(max > min ? m_nbins / (max - min) : 0.),
+    m_bins(m_nbins > 0 ? m_nbins + 2 : 0, 0.),
+    m_sumw2(m_bins.size(), 0.)
+  {}
+
+  void Histogram::fill(G4double value, G4double weight) {
+    if (m_nbins == 0) {
+      return;
+    }
+    G4int index;
+    if (value < m_min) {
+      index = 0;
+    } else if (value >= m_max) {
+      index = m_nbins + 1;
+    } else {
+      // Guard against rounding putting a value just below max into nbins
+      index = std::min(G4int((value - m_min)*m_scale), m_nbins - 1) + 1;
+    }
+    m_bins[index] += weight;
+    m_sumw2[index] += weight*weight;
+    return;
+  }
+
+  void Histogram::add(Histogram const& other) {
+    if (other.m_nbins != m_nbins || other.m_min != m_min ||
+        other.m_max != m_max) {
+      G4cerr << "Error: Can't add histograms with different binning" << G4endl;
+      return;
+    }
+    for (std::size_t i = 0; i < m_bins.size(); ++i) {
+      m_bins[i] += other.m_bins[i];
+      m_sumw2[i] += other.m_sumw2[i];
+    }
+    return;
+  }
+
+  bool Histogram::enabled() const {
+    return m_nbins > 0;
+  }
+
+  G4int Histogram::get_nbins() const {
+    return m_nbins;
+  }
+
+  G4double Histogram::get_min() const {
+    return m_min;
+  }
+
+  G4double Histogram::get_max() const {
+    return m_max;
+  }
+
+  G4double Histogram::get_bin(G4int bin) const {
+    if (m_nbins == 0 || bin < -1 || bin > m_nbins) {
+      return 0.;
+    }
+    return m_bins[bin + 1];
+  }
+
+  G4double Histogram::get_sumw2(G4int bin) const {
+    if (m_nbins == 0 || bin < -1 || bin > m_nbins) {
+      return 0.;
+    }
+    return m_sumw2[bin + 1];
+  }
+
+  void Histogram::write(std::ostream& out, G4String const& prefix,
+      G4double unit) const {
+    auto inf = std::numeric_limits<G4double>::infinity();
+    auto width = (m_max - m_min) / m_nbins;
+    for (G4int bin = -1; bin <= m_nbins; ++bin) {
+      auto low = bin < 0 ? -inf : m_min + bin*width;
+      auto high = bin == m_nbins ? inf : m_min + (bin + 1)*width;
+      out << prefix << "," << bin << "," << low / unit << "," << high / unit
+        << "," << m_bins[bin + 1] << "," << m_sumw2[bin + 1] << "\n";
+    }
+    return;
+  }
+}
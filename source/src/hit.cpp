@@ -1,22 +1,24 @@
 #include "hit.hpp"
+#include "stringtable.hpp"
 
 namespace ne697 {
   /****** GEANT4 BOILERPLATE ******/
   G4ThreadLocal G4Allocator<Hit>* HitAllocator = nullptr;
   /****** GEANT4 BOILERPLATE ******/
 
-  Hit::Hit(int track_id, int parent_id, G4String const& volume,
-         G4String const& particle, G4String const& process,
-         G4ThreeVector const& position, float energy, double time)
+  Hit::Hit(int track_id, int parent_id, G4int volume_id, G4int particle_id,
+         G4int process_id, G4ThreeVector const& position, float energy,
+         double time, float weight)
     : m_eventID(-1),
       m_trackID(track_id),
       m_parentID(parent_id),
-      m_volume(volume),
-      m_particle(particle),
-      m_process(process),
+      m_volumeID(volume_id),
+      m_particleID(particle_id),
+      m_processID(process_id),
       m_position(position),
       m_energy(energy),
-      m_time(time) {}
+      m_time(time),
+      m_weight(weight) {}
   
 void Hit::setEventID(int id) {
   m_eventID = id; 
@@ -29,15 +31,29 @@ int Hit::getTrackID() const { return m_trackID; }
 
 int Hit::getParentID() const { return m_parentID; }
 
-G4String const& Hit::getVolume() const { return m_volume; }
+G4String const& Hit::getVolume() const {
+  return StringTable::lookup(m_volumeID);
+}
+
+G4String const& Hit::getParticle() const {
+  return StringTable::lookup(m_particleID);
+}
 
-G4String const& Hit::getParticle() const { return m_particle; }
+G4String const& Hit::getProcess() const {
+  return StringTable::lookup(m_processID);
+}
 
-G4String const& Hit::getProcess() const { return m_process; }
+G4int Hit::getVolumeID() const { return m_volumeID; }
+
+G4int Hit::getParticleID() const { return m_particleID; }
+
+G4int Hit::getProcessID() const { return m_processID; }
 
 G4ThreeVector const& Hit::getPosition() const { return m_position; }
 
 float Hit::getEnergy() const { return m_energy; }
 
 double Hit::getTime() const { return m_time; }
+
+float Hit::getWeight() const { return m_weight; }
 }
@@ -0,0 +1,28 @@
+#include "hitwriter.hpp"
+#include "columnarwriter.hpp"
+#include "csvwriter.hpp"
+
+namespace ne697 {
+  HitWriter::HitWriter(G4String const& path):
+    m_path(path),
+    m_count(0)
+  {}
+
+  HitWriter::~HitWriter() {}
+
+  G4String const& HitWriter::get_path() const {
+    return m_path;
+  }
+
+  std::size_t HitWriter::get_count() const {
+    return m_count;
+  }
+
+  HitWriter* HitWriter::create(G4String const& format, G4String const& path,
+      bool header) {
+    if (format == "columnar") {
+      return new ColumnarWriter(path);
+    }
+    return new CsvWriter(path, header);
+  }
+}
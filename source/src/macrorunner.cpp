@@ -0,0 +1,160 @@
+#include "macrorunner.hpp"
+#include <fstream>
+#include <sstream>
+#include "G4UImanager.hh"
+
+namespace ne697 {
+  namespace {
+    // Guards against macros that execute themselves
+    G4int const max_depth = 32;
+
+    // The command path, i.e. everything up to the first space
+    G4String command_name(G4String const& command) {
+      return command.substr(0, command.find(' '));
+    }
+  }
+
+  MacroRunner::MacroRunner():
+    m_overrides()
+  {}
+
+  void MacroRunner::add_override(G4String const& command,
+      G4String const& value) {
+    m_overrides.emplace_back(command, value);
+    return;
+  }
+
+  bool MacroRunner::run(std::vector<G4String> const& macros) {
+    std::set<G4String> used;
+    for (auto const& macro : macros) {
+      collect_commands(macro, used, 0);
+    }
+    for (auto const& entry : m_overrides) {
+      if (used.count(entry.first) == 0 &&
+          !apply(entry.first + " " + entry.second)) {
+        return false;
+      }
+    }
+    for (auto const& macro : macros) {
+      if (!execute(macro, 0)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool MacroRunner::read_macro(G4String const& path,
+      std::vector<G4String>& commands) const {
+    std::ifstream in_file(path);
+    if (!in_file.good()) {
+      return false;
+    }
+    // Same rules as G4UIbatch: '#' starts a comment, and a lone '\' or '_'
+    // continues the command on the next line
+    G4String command = "";
+    std::string line;
+    while (std::getline(in_file, line)) {
+      std::istringstream tokens(line);
+      std::string token;
+      bool continued = false;
+      while (tokens >> token) {
+        if (token[0] == '#') {
+          break;
+        }
+        if (token == "\\" || token == "_") {
+          continued = true;
+          break;
+        }
+        command += (command.empty() ? "" : " ") + token;
+      }
+      if (continued || command.empty()) {
+        continue;
+      }
+      commands.push_back(command);
+      command = "";
+    }
+    if (!command.empty()) {
+      commands.push_back(command);
+    }
+    return true;
+  }
+
+  void MacroRunner::collect_commands(G4String const& path,
+      std::set<G4String>& paths, G4int depth) const {
+    std::vector<G4String> commands;
+    if (depth > max_depth || !read_macro(find_macro(path), commands)) {
+      // execute() reports the problem when it gets there
+      return;
+    }
+    for (auto const& command : commands) {
+      auto name = command_name(command);
+      if (name == "/control/execute" && command.size() > name.size()) {
+        collect_commands(command.substr(name.size() + 1), paths, depth + 1);
+      } else {
+        paths.insert(name);
+      }
+    }
+    return;
+  }
+
+  bool MacroRunner::execute(G4String const& path, G4int depth) {
+    if (depth > max_depth) {
+      G4cerr << "Error: Macros nested more than " << max_depth
+        << " deep at " << path << G4endl;
+      return false;
+    }
+    std::vector<G4String> commands;
+    if (!read_macro(find_macro(path), commands)) {
+      G4cerr << "Error: Can't read macro " << path << G4endl;
+      return false;
+    }
+    for (auto& command : commands) {
+      auto name = command_name(command);
+      if (name == "exit") {
+        break;
+      }
+      // Nested macros go through here too, so the overrides reach them
+      if (name == "/control/execute" && command.size() > name.size()) {
+        // SolveAlias() has already complained if it returns nothing
+        G4String nested = G4UImanager::GetUIpointer()->SolveAlias(command);
+        if (nested.size() <= name.size() ||
+            !execute(nested.substr(name.size() + 1), depth + 1)) {
+          return false;
+        }
+        continue;
+      }
+      for (auto const& entry : m_overrides) {
+        if (entry.first == name) {
+          command = name + " " + entry.second;
+        }
+      }
+      if (!apply(command)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool MacroRunner::apply(G4String const& command) {
+    auto ui_manager = G4UImanager::GetUIpointer();
+    // In MT mode the master passes commands it doesn't know on to the
+    // workers and reports success, so check the path here
+    auto name = command_name(ui_manager->SolveAlias(command));
+    if (!ui_manager->GetTree()->FindPath(name)) {
+      G4cerr << "Error: Unknown command " << name << G4endl;
+      return false;
+    }
+    auto status = ui_manager->ApplyCommand(command);
+    if (status != 0) {
+      G4cerr << "Error: Command \"" << command << "\" failed with status "
+        << status << G4endl;
+      return false;
+    }
+    return true;
+  }
+
+  G4String MacroRunner::find_macro(G4String const& path) const {
+    // Honours /control/macroPath like /control/execute does
+    return G4UImanager::GetUIpointer()->FindMacroPath(path);
+  }
+}
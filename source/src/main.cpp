@@ -1,4 +1,5 @@
 #include "G4RunManagerFactory.hh"
+#include "G4Threading.hh"
 #include "G4UIExecutive.hh"
 #include "G4VisExecutive.hh"
 #include "G4UImanager.hh"
@@ -6,38 +7,159 @@
 #include "actioninitialization.hpp"
 #include "detectorconstruction.hpp"
 #include "G4OpticalPhysics.hh"
+#include "G4RadioactiveDecayPhysics.hh"
+#include "Randomize.hh"
+#include "macrorunner.hpp"
+#include "sweep.hpp"
+#include "workercommands.hpp"
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    void print_usage(char const* program) {
+        G4cerr << "Usage: " << program << " [options] [macro...]\n"
+            << "  Runs the macros in order; with none, starts the interactive\n"
+            << "  UI with visualization\n"
+            << "  -t, --threads N     worker threads (batch default: all cores)\n"
+            << "  --type TYPE         run manager: serial, mt, tasking or default\n"
+            << "  -D CMD=VALUE        override a UI command, e.g.\n"
+            << "                      -D /ne697/geometry/det_radius=40cm; replaces\n"
+            << "                      the value wherever the macros set it\n"
+            << "                      Unknown commands and values the command\n"
+            << "                      rejects (range, candidates) exit non-zero\n"
+            << "  -s, --seed N        random seed\n"
+            << "  -o, --output PATH   hits output path (/ne697/run/save_path)\n"
+            << "  -r, --radioactive-decay\n"
+            << "                      add radioactive decay to the physics, for\n"
+            << "                      /ne697/gun/isotope sources (e.g. Ar42.mac)\n"
+            << "  -h, --help          show this message" << G4endl;
+        return;
+    }
+}
 
 int main(int argc, char* argv[]) {
-    auto* run_manager = G4RunManagerFactory::CreateRunManager(
-        G4RunManagerType::Default);
+    // Command-line options
+    std::vector<G4String> macros;
+    ne697::MacroRunner runner;
+    G4int n_threads = 0;
+    auto type = G4RunManagerType::Default;
+    bool seeded = false;
+    bool radioactive_decay = false;
+    long seed = 0;
+    for (int i = 1; i < argc; ++i) {
+        G4String arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        } else if ((arg == "-t" || arg == "--threads") && i + 1 < argc) {
+            n_threads = std::atoi(argv[++i]);
+            if (n_threads < 1) {
+                G4cerr << "Error: Thread count must be at least 1" << G4endl;
+                return 1;
+            }
+        } else if (arg == "--type" && i + 1 < argc) {
+            G4String name = argv[++i];
+            if (name == "serial") {
+                type = G4RunManagerType::Serial;
+            } else if (name == "mt") {
+                type = G4RunManagerType::MT;
+            } else if (name == "tasking") {
+                type = G4RunManagerType::Tasking;
+            } else if (name == "default") {
+                type = G4RunManagerType::Default;
+            } else {
+                G4cerr << "Error: Unknown run manager type " << name << G4endl;
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg.substr(0, 2) == "-D" && (arg.size() > 2 || i + 1 < argc)) {
+            // Both "-D CMD=VALUE" and "-DCMD=VALUE", and a space works in
+            // place of the '='
+            G4String setting = arg.size() > 2 ? arg.substr(2) : argv[++i];
+            auto split = setting.find_first_of("= ");
+            if (setting[0] != '/' || split == std::string::npos) {
+                G4cerr << "Error: Overrides look like -D /path/to/command=value"
+                    << G4endl;
+                return 1;
+            }
+            runner.add_override(setting.substr(0, split),
+                setting.substr(split + 1));
+        } else if ((arg == "-s" || arg == "--seed") && i + 1 < argc) {
+            seed = std::atol(argv[++i]);
+            seeded = true;
+        } else if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+            runner.add_override("/ne697/run/save_path", argv[++i]);
+        } else if (arg == "-r" || arg == "--radioactive-decay") {
+            radioactive_decay = true;
+        } else if (arg[0] != '-') {
+            macros.push_back(arg);
+        } else {
+            G4cerr << "Error: Unknown or incomplete option " << arg << G4endl;
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    // Batch jobs should fill the node; interactive sessions keep whatever
+    // init_vis.mac asks for
+    if (n_threads == 0 && !macros.empty()) {
+        n_threads = G4Threading::G4GetNumberOfCores();
+    }
+
+    auto* run_manager = G4RunManagerFactory::CreateRunManager(type, n_threads);
+    // In MT mode the workers are seeded from the master's engine, so this
+    // fixes every thread's sequence
+    if (seeded) {
+        G4Random::setTheSeed(seed);
+    }
     // Physics
     auto physics_list = new QGSP_BERT_HP;
     // auto physics_list = new G4OpticalPhysics;
     physics_list->SetVerboseLevel(0);
     physics_list->RegisterPhysics(new G4OpticalPhysics);
+    // So ions fired by /ne697/gun/isotope (and any made in the tracking)
+    // decay, through the whole chain. Opt-in, since it changes the physics
+    // and start-up time of every other run
+    if (radioactive_decay) {
+        physics_list->RegisterPhysics(new G4RadioactiveDecayPhysics);
+    }
     run_manager->SetUserInitialization(physics_list);
     // Geometry
     run_manager->SetUserInitialization(new ne697::DetectorConstruction);
     // Action classes
     run_manager->SetUserInitialization(new ne697::ActionInitialization);
+    // Master-only /ne697/sweep/ commands
+    auto sweep = new ne697::Sweep;
+    // So the master can check the worker-only commands
+    ne697::WorkerCommands* worker_commands = nullptr;
+    if (G4Threading::IsMultithreadedApplication()) {
+        worker_commands = new ne697::WorkerCommands;
+    }
 
-    // Check number of command-line args, which controls whether we run
-    // in visual mode or batch mode
+    // Whether any macros were given controls whether we run in visual mode
+    // or batch mode
     G4VisManager* vis_manager = nullptr;
     auto ui_manager = G4UImanager::GetUIpointer();
-    if (argc == 1) {
+    int status = 0;
+    if (macros.empty()) {
         vis_manager = new G4VisExecutive;
         vis_manager->Initialize();
         auto ui = new G4UIExecutive(argc, argv);
         ui_manager->ApplyCommand("/control/macroPath scripts/");
-        ui_manager->ApplyCommand("/control/execute scripts/init_vis.mac");
-        ui->SessionStart();
+        // With no macros, this just applies the overrides
+        if (runner.run(macros)) {
+            ui_manager->ApplyCommand("/control/execute scripts/init_vis.mac");
+            ui->SessionStart();
+        } else {
+            status = 1;
+        }
         delete ui;
-    } else if (argc == 2) {
-        G4String cmd = "/control/execute " + (G4String)argv[1];
-        ui_manager->ApplyCommand(cmd);
+    } else if (!runner.run(macros)) {
+        // Non-zero, so job schedulers see the failure
+        status = 1;
     }
+    delete worker_commands;
+    delete sweep;
     delete vis_manager;
     delete run_manager;
-    return 0;
+    return status;
 }
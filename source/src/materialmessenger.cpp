@@ -43,7 +43,8 @@ namespace ne697 {
         << G4endl;
     }
 
-    // Command didn't match
+    // Both commands change what Construct() builds
+    m_dc->reinitialize();
     return;
   }
 }
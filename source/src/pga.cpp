@@ -1,22 +1,121 @@
 #include "pga.hpp"
+#include "G4Event.hh"
 #include "G4Gamma.hh"
+#include "G4PrimaryVertex.hh"
 #include "G4SystemOfUnits.hh"
 #include "Randomize.hh"
 #include "gunmessenger.hpp"
-#include "detectorconstruction.hpp"
-#include "geometrymessenger.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include "G4IonTable.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4ProcessTable.hh"
+#include "G4RandomDirection.hh"
+#include "G4RunManager.hh"
+#include "G4TransportationManager.hh"
 
 
 namespace ne697 {
+  namespace {
+    // Volume mode gives up on a point after this many misses, which only
+    // happens if the volume is (nearly) all daughters
+    G4int const max_tries = 1000000;
+
+    G4String const position_modes[] = {
+      "halfcylinder", "point", "volume", "surface"
+    };
+
+    // Composes the placements of volume up to the world, so that global =
+    // rotation*local + translation. A volume only knows its mother's
+    // logical volume, so find where that is placed. Returns false, after
+    // printing why, if that isn't a single plain placement all the way up,
+    // since then the volume has no one global position
+    bool find_placement(G4VPhysicalVolume const* volume,
+        G4RotationMatrix& rotation, G4ThreeVector& translation) {
+      auto store = G4PhysicalVolumeStore::GetInstance();
+      auto const& name = volume->GetName();
+      if (volume->IsReplicated() || std::count_if(store->begin(),
+            store->end(), [&](G4VPhysicalVolume const* candidate) {
+              return candidate->GetName() == name;
+            }) > 1) {
+        G4cerr << "Error: There is more than one " << name << G4endl;
+        return false;
+      }
+      rotation = volume->GetObjectRotationValue();
+      translation = volume->GetObjectTranslation();
+      auto mother = volume->GetMotherLogical();
+      while (mother) {
+        G4VPhysicalVolume* placement = nullptr;
+        for (auto candidate : *store) {
+          if (candidate->GetLogicalVolume() != mother) {
+            continue;
+          }
+          if (placement || candidate->IsReplicated()) {
+            G4cerr << "Error: " << name << " is inside " << mother->GetName()
+              << ", which is placed more than once" << G4endl;
+            return false;
+          }
+          placement = candidate;
+        }
+        if (!placement) {
+          break;
+        }
+        auto mother_rotation = placement->GetObjectRotationValue();
+        translation = mother_rotation*translation +
+          placement->GetObjectTranslation();
+        rotation = mother_rotation*rotation;
+        mother = placement->GetMotherLogical();
+      }
+      return true;
+    }
+  }
+
   PGA::PGA():
     G4VUserPrimaryGeneratorAction(),
     m_gun(new G4ParticleGun(1)),
-    m_offset(30*cm)
+    m_geometry(nullptr),
+    // DetectorConstruction's default, until the first snapshot
+    m_detRadius(50*cm),
+    m_fSphere(false),
+    m_offset(30*cm),
+    m_batchSize(1),
+    m_random(),
+    m_x(),
+    m_y(),
+    m_z(),
+    m_next(0),
+    m_positionMode(HalfCylinder),
+    m_sourceName(""),
+    m_directionMode("gun"),
+    m_biasName("physHPGE"),
+    m_biasFraction(0.9),
+    m_sourceRun(-1),
+    m_sourceVolume(nullptr),
+    m_sourceRotation(),
+    m_sourceTranslation(),
+    m_sourceMin(),
+    m_sourceMax(),
+    m_biasVolume(nullptr),
+    m_biasCentre(),
+    m_biasRadius(0.),
+    m_fWarnedBias(false),
+    m_navigator(new G4Navigator),
+    m_spectrum(),
+    m_isotopes(),
+    m_isotopeWeights(),
+    m_isotopeTable(),
+    m_isotopeIons(),
+    m_fGunSaved(false),
+    m_gunParticle(nullptr),
+    m_gunEnergy(0.)
   {
     G4cout << "Creating PGA" << G4endl;
     m_messenger = new GunMessenger(this);
     m_gun->SetParticleDefinition(G4Gamma::Definition());
     m_gun->SetParticleEnergy(1.*MeV);
+    update_geometry();
     
     //Set direction to be -Y axis
     // m_gun->SetParticleMomentumDirection(G4ThreeVector(0., -1., 0.));
@@ -27,16 +126,264 @@ namespace ne697 {
     G4cout << "Deleting PGA" << G4endl;
     delete m_messenger;
     delete m_gun;
-    delete m_geo;
+    delete m_navigator;
   }
 
   void PGA::GeneratePrimaries(G4Event* event) {
-    
-    // G4double det_radius = m_geo->get_det_radius();
-    G4double det_radius = 50*cm;
-    // G4String det_shape = DetectorConstruction().get_det_geometry();
+    auto run_id = G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID();
+    if (run_id != m_sourceRun) {
+      update_source();
+      m_sourceRun = run_id;
+    }
+    if (!m_fGunSaved && (!m_isotopeIons.empty() || !m_spectrum.empty())) {
+      // For clear_isotopes() and clear_spectrum() to go back to
+      m_gunParticle = m_gun->GetParticleDefinition();
+      m_gunEnergy = m_gun->GetParticleEnergy();
+      m_fGunSaved = true;
+    }
+    if (!m_isotopeIons.empty()) {
+      // At rest, and radioactive decay does the rest
+      m_gun->SetParticleDefinition(m_isotopeIons[m_isotopeTable.sample()]);
+      m_gun->SetParticleEnergy(0.);
+    } else if (!m_spectrum.empty()) {
+      m_gun->SetParticleEnergy(m_spectrum.sample());
+    }
+    if (m_directionMode == "isotropic") {
+      m_gun->SetParticleMomentumDirection(G4RandomDirection());
+    }
+    // //Generate random position of particle within region of interest
+    auto position = next_position();
+    m_gun->SetParticlePosition(position);
+    // m_gun->SetParticlePosition(G4ThreeVector(0.*cm, 0.*cm, 0.*cm));
+    G4double weight = 1.;
+    if (m_directionMode == "biased") {
+      // An at-rest primary's direction says nothing about where its decay
+      // products go, so a weight from it would only skew the tallies
+      if (!m_isotopeIons.empty() || m_gun->GetParticleEnergy() == 0.) {
+        if (!m_fWarnedBias) {
+          G4cerr << "Warning: Not biasing primaries at rest; they get "
+            << "weight 1" << G4endl;
+          m_fWarnedBias = true;
+        }
+        m_gun->SetParticleMomentumDirection(G4RandomDirection());
+      } else {
+        m_gun->SetParticleMomentumDirection(sample_biased(position, weight));
+      }
+    }
+    m_gun->GeneratePrimaryVertex(event);
+    // Tracks get the vertex weight, and pass it on to their secondaries
+    event->GetPrimaryVertex(event->GetNumberOfPrimaryVertex() - 1)
+      ->SetWeight(weight);
+    return;
+  }
+
+  void PGA::update_geometry() {
+    auto geometry = GeometryParameters::current();
+    if (!geometry || geometry == m_geometry) {
+      return;
+    }
+    m_geometry = geometry;
+    m_detRadius = geometry->det_radius;
+    m_fSphere = geometry->det_geometry == "Sphere";
+    // Drop any batched positions drawn for the old shell
+    m_next = m_x.size();
+    return;
+  }
+
+  void PGA::update_source() {
+    update_geometry();
+    m_fWarnedBias = false;
+    m_isotopeIons.clear();
+    auto ion_table = G4IonTable::GetIonTable();
+    for (std::size_t i = 0; i < m_isotopes.size();) {
+      auto ion = ion_table->GetIon(m_isotopes[i].first, m_isotopes[i].second,
+          0.);
+      if (ion) {
+        m_isotopeIons.push_back(ion);
+        ++i;
+        continue;
+      }
+      G4cerr << "Error: No ion for isotope Z = " << m_isotopes[i].first
+        << ", A = " << m_isotopes[i].second << ", dropping it" << G4endl;
+      m_isotopes.erase(m_isotopes.begin() + i);
+      m_isotopeWeights.erase(m_isotopeWeights.begin() + i);
+      m_isotopeTable = m_isotopeWeights.empty() ? AliasTable() :
+        AliasTable(m_isotopeWeights);
+    }
+    // In case that dropped the last of them
+    restore_gun();
+    // Without it the ions just sit there
+    auto process_table = G4ProcessTable::GetProcessTable();
+    if (!m_isotopeIons.empty() &&
+        !process_table->FindProcess("Radioactivation", "GenericIon") &&
+        !process_table->FindProcess("RadioactiveDecay", "GenericIon")) {
+      G4cerr << "Warning: Isotope sources need radioactive decay in the "
+        << "physics (sim -r); the ions won't decay" << G4endl;
+    }
+
+    auto store = G4PhysicalVolumeStore::GetInstance();
+    m_biasVolume = nullptr;
+    if (m_directionMode == "biased") {
+      m_biasVolume = store->GetVolume(m_biasName, false);
+      G4RotationMatrix rotation;
+      G4ThreeVector translation, local_min, local_max;
+      if (!m_biasVolume) {
+        G4cerr << "Error: Unknown bias volume " << m_biasName
+          << ", firing isotropically" << G4endl;
+      } else if (!find_placement(m_biasVolume, rotation, translation)) {
+        G4cerr << "Error: Bias volume " << m_biasName
+          << " has no single position, firing isotropically" << G4endl;
+        m_biasVolume = nullptr;
+      } else {
+        m_biasVolume->GetLogicalVolume()->GetSolid()->BoundingLimits(
+            local_min, local_max);
+        m_biasCentre = rotation*(0.5*(local_min + local_max)) + translation;
+        m_biasRadius = 0.5*(local_max - local_min).mag();
+      }
+    }
+
+    m_sourceVolume = nullptr;
+    if (m_positionMode != Volume && m_positionMode != Surface) {
+      return;
+    }
+    m_sourceVolume = store->GetVolume(m_sourceName, false);
+    if (!m_sourceVolume) {
+      G4cerr << "Error: Unknown source volume " << m_sourceName
+        << ", firing from the origin" << G4endl;
+      return;
+    }
+    if (!find_placement(m_sourceVolume, m_sourceRotation,
+          m_sourceTranslation)) {
+      G4cerr << "Error: Source volume " << m_sourceName
+        << " has no single position, firing from the origin" << G4endl;
+      m_sourceVolume = nullptr;
+      return;
+    }
+    // Global box around the rotated local one
+    G4ThreeVector local_min, local_max;
+    m_sourceVolume->GetLogicalVolume()->GetSolid()->BoundingLimits(local_min,
+        local_max);
+    m_sourceMin = G4ThreeVector(DBL_MAX, DBL_MAX, DBL_MAX);
+    m_sourceMax = -m_sourceMin;
+    for (int corner = 0; corner < 8; ++corner) {
+      G4ThreeVector local(corner & 1 ? local_max.x() : local_min.x(),
+          corner & 2 ? local_max.y() : local_min.y(),
+          corner & 4 ? local_max.z() : local_min.z());
+      auto global = m_sourceRotation*local + m_sourceTranslation;
+      for (int i = 0; i < 3; ++i) {
+        m_sourceMin[i] = std::min(m_sourceMin[i], global[i]);
+        m_sourceMax[i] = std::max(m_sourceMax[i], global[i]);
+      }
+    }
+    m_navigator->SetWorldVolume(G4TransportationManager::
+        GetTransportationManager()->GetNavigatorForTracking()->GetWorldVolume());
+    return;
+  }
+
+  G4ThreeVector PGA::next_position() {
+    switch (m_positionMode) {
+      case Point:
+        return G4ThreeVector(0., m_offset, 0.);
+      case Volume:
+        return sample_volume();
+      case Surface:
+        return sample_surface();
+      default:
+        return next_halfcylinder();
+    }
+  }
+
+  G4ThreeVector PGA::sample_volume() {
+    if (!m_sourceVolume) {
+      return G4ThreeVector();
+    }
+    // Rejection from the bounding box. Asking the navigator, rather than
+    // the solid, also rejects points in the volume's daughters
+    for (G4int i = 0; i < max_tries; ++i) {
+      G4ThreeVector point(
+          m_sourceMin.x() + G4UniformRand()*(m_sourceMax.x() - m_sourceMin.x()),
+          m_sourceMin.y() + G4UniformRand()*(m_sourceMax.y() - m_sourceMin.y()),
+          m_sourceMin.z() + G4UniformRand()*(m_sourceMax.z() - m_sourceMin.z()));
+      if (m_navigator->LocateGlobalPointAndSetup(point, nullptr, false, true) ==
+          m_sourceVolume) {
+        return point;
+      }
+    }
+    G4cerr << "Error: No point found in source volume " << m_sourceName
+      << " after " << max_tries << " tries" << G4endl;
+    return m_sourceTranslation;
+  }
+
+  G4ThreeVector PGA::sample_surface() const {
+    if (!m_sourceVolume) {
+      return G4ThreeVector();
+    }
+    auto solid = m_sourceVolume->GetLogicalVolume()->GetSolid();
+    return m_sourceRotation*solid->GetPointOnSurface() + m_sourceTranslation;
+  }
+
+  G4ThreeVector PGA::sample_biased(G4ThreeVector const& position,
+      G4double& weight) const {
+    auto axis = m_biasCentre - position;
+    auto const distance = axis.mag();
+    if (!m_biasVolume || distance <= m_biasRadius) {
+      // Inside the sphere every direction points near the target anyway
+      weight = 1.;
+      return G4RandomDirection();
+    }
+    axis /= distance;
+    // 1 - cos of the cone's half angle, written so it doesn't cancel out
+    // for a small, distant target
+    auto const sin2 = (m_biasRadius/distance)*(m_biasRadius/distance);
+    auto const cos_alpha = std::sqrt(1. - sin2);
+    auto const one_minus_cos = sin2/(1. + cos_alpha);
+
+    G4ThreeVector direction;
+    if (G4UniformRand() < m_biasFraction) {
+      // Uniform over the cone's solid angle
+      auto const cos_theta = 1. - G4UniformRand()*one_minus_cos;
+      auto const sin_theta = std::sqrt(
+          std::max(0., (1. - cos_theta)*(1. + cos_theta)));
+      auto const phi = CLHEP::twopi*G4UniformRand();
+      direction.set(sin_theta*std::cos(phi), sin_theta*std::sin(phi),
+          cos_theta);
+      direction.rotateUz(axis);
+    } else {
+      direction = G4RandomDirection();
+    }
+    // The draw came from the mixture
+    //   pdf = (1 - f)/(4 pi) + f/(2 pi (1 - cos alpha)) inside the cone,
+    // against the isotropic 1/(4 pi), whichever branch produced it
+    G4double ratio = 1. - m_biasFraction;
+    if (direction.dot(axis) >= cos_alpha) {
+      ratio += 2.*m_biasFraction/one_minus_cos;
+    }
+    weight = 1./ratio;
+    return direction;
+  }
+
+  G4ThreeVector PGA::next_halfcylinder() {
+    G4ThreeVector position;
+    // A spherical shell gets the same distribution, cut down to the part
+    // inside the sphere
+    do {
+      if (m_batchSize <= 1) {
+        position = sample_position();
+      } else {
+        if (m_next >= m_x.size()) {
+          fill_positions();
+        }
+        auto const i = m_next++;
+        position.set(m_x[i], m_y[i], m_z[i]);
+      }
+    } while (m_fSphere && position.mag2() > m_detRadius*m_detRadius);
+    return position;
+  }
+
+  G4ThreeVector PGA::sample_position() const {
+    auto const det_radius = m_detRadius;
     G4double x_pos, y_pos, z_pos;
-  
+
     G4double phi = G4UniformRand()*CLHEP::pi; //*rad;
     G4double height =  (G4UniformRand()-0.5)*2.0*det_radius;
     x_pos = G4UniformRand()*det_radius*std::cos(phi*rad);
@@ -49,10 +396,54 @@ namespace ne697 {
     //                 <<det_radius<<"  "
     // 	    				  <<z_pos<<G4endl;
 
-    // //Generate random position of particle within region of interest
-    m_gun->SetParticlePosition(G4ThreeVector(x_pos*mm, y_pos*mm, z_pos*mm));
-    // m_gun->SetParticlePosition(G4ThreeVector(0.*cm, 0.*cm, 0.*cm));
-    m_gun->GeneratePrimaryVertex(event);
+    return G4ThreeVector(x_pos*mm, y_pos*mm, z_pos*mm);
+  }
+
+  void PGA::fill_positions() {
+    std::size_t const n = m_batchSize;
+    auto const det_radius = m_detRadius;
+    m_random.resize(4*n);
+    m_x.resize(n);
+    m_y.resize(n);
+    m_z.resize(n);
+    // One virtual call into this thread's engine instead of four per
+    // event. The draws are used in the same order as sample_position()
+    // uses them: phi, height, then the x and y radial fractions
+    G4Random::getTheEngine()->flatArray(4*n, m_random.data());
+    auto const* u = m_random.data();
+    for (std::size_t i = 0; i < n; ++i) {
+      m_z[i] = (u[4*i + 1] - 0.5)*2.0*det_radius;
+      // Angle first, so the cos/sin loop below reads contiguous memory
+      m_x[i] = u[4*i]*CLHEP::pi;
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      auto const phi = m_x[i];
+      m_x[i] = u[4*i + 2]*det_radius*std::cos(phi);
+      m_y[i] = u[4*i + 3]*det_radius*std::sin(phi);
+    }
+    m_next = 0;
+    return;
+  }
+
+  void PGA::benchmark(G4int n_events) {
+    using clock = std::chrono::steady_clock;
+    // Summed so the compiler can't drop the unused positions
+    G4ThreeVector sum;
+    auto start = clock::now();
+    for (G4int i = 0; i < n_events; ++i) {
+      sum += sample_position();
+    }
+    std::chrono::duration<G4double, std::nano> single = clock::now() - start;
+    m_next = m_x.size();
+    start = clock::now();
+    for (G4int i = 0; i < n_events; ++i) {
+      sum += next_halfcylinder();
+    }
+    std::chrono::duration<G4double, std::nano> batched = clock::now() - start;
+    G4cout << "Source sampling over " << n_events << " events: "
+      << single.count()/n_events << " ns/event one at a time, "
+      << batched.count()/n_events << " ns/event in batches of "
+      << m_batchSize << " (checksum " << sum.mag() << ")" << G4endl;
     return;
   }
 
@@ -64,4 +455,125 @@ namespace ne697 {
   G4double const& PGA::get_gun_offset() const {
     return m_offset;
   }
+
+  void PGA::set_batch_size(G4int const& size) {
+    m_batchSize = size;
+    // Anything left over was drawn for the old size; drop it
+    m_next = m_x.size();
+    return;
+  }
+
+  G4int const& PGA::get_batch_size() const {
+    return m_batchSize;
+  }
+
+  void PGA::set_position_mode(G4String const& mode) {
+    for (int i = 0; i < 4; ++i) {
+      if (mode == position_modes[i]) {
+        m_positionMode = PositionMode(i);
+      }
+    }
+    // Picked up at the start of the next run
+    m_sourceRun = -1;
+    return;
+  }
+
+  G4String PGA::get_position_mode() const {
+    return position_modes[m_positionMode];
+  }
+
+  void PGA::set_source_volume(G4String const& name) {
+    m_sourceName = name;
+    m_sourceRun = -1;
+    return;
+  }
+
+  G4String const& PGA::get_source_volume() const {
+    return m_sourceName;
+  }
+
+  void PGA::set_direction_mode(G4String const& mode) {
+    m_directionMode = mode;
+    // The bias volume is looked up at the start of the next run
+    m_sourceRun = -1;
+    return;
+  }
+
+  G4String const& PGA::get_direction_mode() const {
+    return m_directionMode;
+  }
+
+  void PGA::set_bias_volume(G4String const& name) {
+    m_biasName = name;
+    m_sourceRun = -1;
+    return;
+  }
+
+  G4String const& PGA::get_bias_volume() const {
+    return m_biasName;
+  }
+
+  void PGA::set_bias_fraction(G4double const& fraction) {
+    m_biasFraction = fraction;
+    return;
+  }
+
+  G4double const& PGA::get_bias_fraction() const {
+    return m_biasFraction;
+  }
+
+  void PGA::add_spectrum_line(G4double const& energy, G4double const& weight) {
+    m_spectrum.add_line(energy, weight);
+    return;
+  }
+
+  bool PGA::load_spectrum(G4String const& path) {
+    return m_spectrum.load(path);
+  }
+
+  void PGA::clear_spectrum() {
+    m_spectrum.clear();
+    restore_gun();
+    return;
+  }
+
+  std::size_t PGA::get_spectrum_size() const {
+    return m_spectrum.size();
+  }
+
+  void PGA::test_spectrum(G4int n_samples) {
+    m_spectrum.test(n_samples);
+    return;
+  }
+
+  void PGA::add_isotope(G4int z, G4int a, G4double const& weight) {
+    m_isotopes.emplace_back(z, a);
+    m_isotopeWeights.push_back(weight);
+    m_isotopeTable = AliasTable(m_isotopeWeights);
+    m_sourceRun = -1;
+    return;
+  }
+
+  void PGA::clear_isotopes() {
+    m_isotopes.clear();
+    m_isotopeWeights.clear();
+    m_isotopeTable = AliasTable();
+    m_isotopeIons.clear();
+    restore_gun();
+    return;
+  }
+
+  std::size_t PGA::get_isotope_count() const {
+    return m_isotopes.size();
+  }
+
+  void PGA::restore_gun() {
+    if (!m_fGunSaved || !m_isotopes.empty() || !m_spectrum.empty()) {
+      return;
+    }
+    m_gun->SetParticleDefinition(m_gunParticle);
+    m_gun->SetParticleEnergy(m_gunEnergy);
+    m_fGunSaved = false;
+    return;
+  }
 }
@@ -0,0 +1,329 @@
+#include "primitivefit.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "G4Box.hh"
+#include "G4DisplacedSolid.hh"
+#include "G4Orb.hh"
+#include "G4PhysicalConstants.hh"
+#include "G4RotationMatrix.hh"
+#include "G4Sphere.hh"
+#include "G4Transform3D.hh"
+#include "G4Tubs.hh"
+#include "G4UnionSolid.hh"
+
+namespace ne697 {
+  namespace {
+    // Eigenvectors of a symmetric 3x3 matrix by Jacobi rotations, returned
+    // as a right-handed set
+    void eigenvectors(G4double m[3][3], G4ThreeVector axes[3]) {
+      G4double v[3][3] = {{1., 0., 0.}, {0., 1., 0.}, {0., 0., 1.}};
+      for (int sweep = 0; sweep < 50; ++sweep) {
+        G4double off = m[0][1]*m[0][1] + m[0][2]*m[0][2] + m[1][2]*m[1][2];
+        if (off < 1e-30) {
+          break;
+        }
+        for (int p = 0; p < 2; ++p) {
+          for (int q = p + 1; q < 3; ++q) {
+            if (m[p][q] == 0.) {
+              continue;
+            }
+            G4double theta = (m[q][q] - m[p][p])/(2.*m[p][q]);
+            G4double t = (theta >= 0. ? 1. : -1.)/
+              (std::abs(theta) + std::sqrt(theta*theta + 1.));
+            G4double c = 1./std::sqrt(t*t + 1.);
+            G4double s = t*c;
+            for (int k = 0; k < 3; ++k) {
+              G4double mkp = m[k][p];
+              G4double mkq = m[k][q];
+              m[k][p] = c*mkp - s*mkq;
+              m[k][q] = s*mkp + c*mkq;
+            }
+            for (int k = 0; k < 3; ++k) {
+              G4double mpk = m[p][k];
+              G4double mqk = m[q][k];
+              m[p][k] = c*mpk - s*mqk;
+              m[q][k] = s*mpk + c*mqk;
+            }
+            for (int k = 0; k < 3; ++k) {
+              G4double vkp = v[k][p];
+              G4double vkq = v[k][q];
+              v[k][p] = c*vkp - s*vkq;
+              v[k][q] = s*vkp + c*vkq;
+            }
+          }
+        }
+      }
+      axes[0] = G4ThreeVector(v[0][0], v[1][0], v[2][0]).unit();
+      axes[1] = G4ThreeVector(v[0][1], v[1][1], v[2][1]).unit();
+      axes[2] = axes[0].cross(axes[1]).unit();
+      return;
+    }
+
+    G4String const shape_names[] = {"sphere", "box", "tube", "capsule"};
+  }
+
+  PrimitiveFit::PrimitiveFit(std::vector<G4ThreeVector> const& points,
+      std::vector<std::size_t> const& indices):
+    m_samples(points),
+    m_area(0.),
+    m_volume(0.),
+    m_centroid(),
+    m_fFaceAxes(false),
+    m_shape("none"),
+    m_error(std::numeric_limits<G4double>::infinity())
+  {
+    // Area-weighted first and second moments of the surface, so the
+    // principal axes don't depend on how finely each part is tessellated
+    G4double second[3][3] = {};
+    G4double largest = 0.;
+    G4ThreeVector first;
+    m_samples.reserve(points.size() + 4*indices.size()/3);
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+      auto const& a = points[indices[i]];
+      auto const& b = points[indices[i + 1]];
+      auto const& c = points[indices[i + 2]];
+      auto normal = (b - a).cross(c - a);
+      G4double area = normal.mag()/2.;
+      auto sum = a + b + c;
+      m_area += area;
+      m_volume += a.dot(b.cross(c))/6.;
+      first += area*sum/3.;
+      for (int j = 0; j < 3; ++j) {
+        for (int k = 0; k < 3; ++k) {
+          second[j][k] += area/12.*(a[j]*a[k] + b[j]*b[k] + c[j]*c[k] +
+              sum[j]*sum[k]);
+        }
+      }
+      if (area > largest) {
+        largest = area;
+        m_faceAxes[0] = normal.unit();
+      }
+      m_samples.push_back(sum/3.);
+      m_samples.push_back((a + b)/2.);
+      m_samples.push_back((b + c)/2.);
+      m_samples.push_back((c + a)/2.);
+    }
+    // Either winding order is fine
+    m_volume = std::abs(m_volume);
+    if (m_area <= 0.) {
+      return;
+    }
+    m_centroid = first/m_area;
+    for (int j = 0; j < 3; ++j) {
+      for (int k = 0; k < 3; ++k) {
+        second[j][k] = second[j][k]/m_area - m_centroid[j]*m_centroid[k];
+      }
+    }
+    eigenvectors(second, m_principal);
+
+    largest = 0.;
+    for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+      auto const& a = points[indices[i]];
+      auto normal = (points[indices[i + 1]] - a).cross(points[indices[i + 2]] - a);
+      G4double area = normal.mag()/2.;
+      if (area > largest && std::abs(normal.unit().dot(m_faceAxes[0])) < 1e-6) {
+        largest = area;
+        m_faceAxes[1] = normal.unit();
+        m_fFaceAxes = true;
+      }
+    }
+    m_faceAxes[2] = m_faceAxes[0].cross(m_faceAxes[1]).unit();
+  }
+
+  G4VSolid* PrimitiveFit::build_solid(G4String const& name,
+      G4double tolerance) {
+    std::vector<Candidate> candidates;
+    if (m_area > 0.) {
+      fit_sphere(candidates);
+      fit_box(m_principal, candidates);
+      fit_round(m_principal, candidates);
+      if (m_fFaceAxes) {
+        fit_box(m_faceAxes, candidates);
+      }
+    }
+
+    // The deviation check alone would accept e.g. half a cylinder as a
+    // whole one, so the enclosed volume has to agree too: the difference,
+    // spread over the surface, must be less than the tolerance. A shape
+    // that fits always beats one that doesn't, then the smaller error wins
+    Candidate const* best = nullptr;
+    bool accepted = false;
+    for (auto& candidate : candidates) {
+      candidate.error = surface_error(candidate);
+      bool fits = candidate.error <= tolerance &&
+        std::abs(candidate.volume - m_volume) <= tolerance*m_area;
+      if (!best || (fits && !accepted) ||
+          (fits == accepted && candidate.error < best->error)) {
+        best = &candidate;
+        accepted = fits;
+      }
+    }
+    if (!best) {
+      m_shape = "none";
+      m_error = std::numeric_limits<G4double>::infinity();
+      return nullptr;
+    }
+    m_shape = shape_names[best->shape];
+    m_error = best->error;
+    if (!accepted) {
+      return nullptr;
+    }
+
+    G4VSolid* solid = nullptr;
+    auto local_name = name + "_" + m_shape;
+    switch (best->shape) {
+      case Sphere:
+        solid = new G4Orb(local_name, best->size[0]);
+        break;
+      case Box:
+        solid = new G4Box(local_name, best->size[0], best->size[1],
+            best->size[2]);
+        break;
+      case Tube:
+        solid = new G4Tubs(local_name, 0., best->size[0], best->size[1],
+            0., CLHEP::twopi);
+        break;
+      case Capsule: {
+        G4double radius = best->size[0];
+        G4double half_length = best->size[1];
+        auto tube = new G4Tubs(name + "_tube", 0., radius, half_length,
+            0., CLHEP::twopi);
+        auto top = new G4Sphere(name + "_top", 0., radius, 0., CLHEP::twopi,
+            0., CLHEP::halfpi);
+        auto bottom = new G4Sphere(name + "_bottom", 0., radius, 0.,
+            CLHEP::twopi, CLHEP::halfpi, CLHEP::halfpi);
+        auto upper = new G4UnionSolid(name + "_upper", tube, top, nullptr,
+            G4ThreeVector(0., 0., half_length));
+        solid = new G4UnionSolid(local_name, upper, bottom, nullptr,
+            G4ThreeVector(0., 0., -half_length));
+        break;
+      }
+    }
+
+    G4RotationMatrix rotation;
+    rotation.rotateAxes(best->axes[0], best->axes[1], best->axes[2]);
+    return new G4DisplacedSolid(name, solid,
+        G4Transform3D(rotation, best->center));
+  }
+
+  G4String const& PrimitiveFit::get_shape() const {
+    return m_shape;
+  }
+
+  G4double PrimitiveFit::get_error() const {
+    return m_error;
+  }
+
+  G4double PrimitiveFit::surface_error(Candidate const& candidate) const {
+    G4double error = 0.;
+    for (auto const& sample : m_samples) {
+      auto offset = sample - candidate.center;
+      G4double x = offset.dot(candidate.axes[0]);
+      G4double y = offset.dot(candidate.axes[1]);
+      G4double z = offset.dot(candidate.axes[2]);
+      G4double distance = 0.;
+      switch (candidate.shape) {
+        case Sphere:
+          distance = offset.mag() - candidate.size[0];
+          break;
+        case Box: {
+          G4double dx = std::abs(x) - candidate.size[0];
+          G4double dy = std::abs(y) - candidate.size[1];
+          G4double dz = std::abs(z) - candidate.size[2];
+          G4double inside = std::max({dx, dy, dz});
+          distance = inside <= 0. ? inside :
+            std::sqrt(std::pow(std::max(dx, 0.), 2) +
+                std::pow(std::max(dy, 0.), 2) + std::pow(std::max(dz, 0.), 2));
+          break;
+        }
+        case Tube: {
+          G4double dr = std::sqrt(x*x + y*y) - candidate.size[0];
+          G4double dz = std::abs(z) - candidate.size[1];
+          distance = (dr <= 0. && dz <= 0.) ? std::max(dr, dz) :
+            std::sqrt(std::pow(std::max(dr, 0.), 2) +
+                std::pow(std::max(dz, 0.), 2));
+          break;
+        }
+        case Capsule: {
+          G4double dz = z - std::clamp(z, -candidate.size[1],
+              candidate.size[1]);
+          distance = std::sqrt(x*x + y*y + dz*dz) - candidate.size[0];
+          break;
+        }
+      }
+      error = std::max(error, std::abs(distance));
+    }
+    return error;
+  }
+
+  void PrimitiveFit::fit_sphere(std::vector<Candidate>& candidates) const {
+    G4double min = std::numeric_limits<G4double>::max();
+    G4double max = 0.;
+    for (auto const& sample : m_samples) {
+      G4double r = (sample - m_centroid).mag();
+      min = std::min(min, r);
+      max = std::max(max, r);
+    }
+    Candidate sphere = {Sphere, m_centroid, {m_principal[0], m_principal[1],
+      m_principal[2]}, {(min + max)/2., 0., 0.}, 0., 0.};
+    sphere.volume = 4./3.*CLHEP::pi*std::pow(sphere.size[0], 3);
+    candidates.push_back(sphere);
+    return;
+  }
+
+  void PrimitiveFit::fit_box(G4ThreeVector const axes[3],
+      std::vector<Candidate>& candidates) const {
+    Candidate box = {Box, G4ThreeVector(), {axes[0], axes[1], axes[2]},
+      {0., 0., 0.}, 0., 1.};
+    for (int i = 0; i < 3; ++i) {
+      G4double min = std::numeric_limits<G4double>::max();
+      G4double max = std::numeric_limits<G4double>::lowest();
+      for (auto const& sample : m_samples) {
+        G4double projection = sample.dot(axes[i]);
+        min = std::min(min, projection);
+        max = std::max(max, projection);
+      }
+      box.center += axes[i]*(min + max)/2.;
+      box.size[i] = (max - min)/2.;
+      box.volume *= 2.*box.size[i];
+    }
+    candidates.push_back(box);
+    return;
+  }
+
+  void PrimitiveFit::fit_round(G4ThreeVector const axes[3],
+      std::vector<Candidate>& candidates) const {
+    // Try each principal axis as the symmetry axis; only the right one
+    // gives a small error
+    for (int k = 0; k < 3; ++k) {
+      auto const& axis = axes[k];
+      G4double min = std::numeric_limits<G4double>::max();
+      G4double max = std::numeric_limits<G4double>::lowest();
+      G4double radius = 0.;
+      for (auto const& sample : m_samples) {
+        auto offset = sample - m_centroid;
+        G4double z = offset.dot(axis);
+        min = std::min(min, z);
+        max = std::max(max, z);
+        radius = std::max(radius, (offset - z*axis).mag());
+      }
+      auto center = m_centroid + axis*(min + max)/2.;
+      G4double half_length = (max - min)/2.;
+      Candidate tube = {Tube, center,
+        {axes[(k + 1)%3], axes[(k + 2)%3], axis},
+        {radius, half_length, 0.}, 0.,
+        CLHEP::pi*radius*radius*2.*half_length};
+      candidates.push_back(tube);
+      if (half_length > radius) {
+        Candidate capsule = tube;
+        capsule.shape = Capsule;
+        capsule.size[1] = half_length - radius;
+        capsule.volume = CLHEP::pi*radius*radius*2.*capsule.size[1] +
+          4./3.*CLHEP::pi*std::pow(radius, 3);
+        candidates.push_back(capsule);
+      }
+    }
+    return;
+  }
+}
@@ -1,20 +1,40 @@
 #include "run.hpp"
 #include "G4Event.hh"
+#include "G4PrimaryVertex.hh"
 #include "G4SDManager.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4THitsCollection.hh"
+#include "G4Threading.hh"
 #include "G4UnitsTable.hh"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 
 namespace ne697 {
   Run::Run():
     G4Run(),
-    m_hits()
+    m_hits(),
+    m_fStoreHits(true),
+    m_binning(),
+    m_histograms(),
+    m_eventEdep(),
+    m_mergeTime(0.),
+    m_mergeCount(0),
+    m_timedEvents(0),
+    m_eventTimeSum(0.),
+    m_eventTimeSum2(0.),
+    m_eventTimeMax(0.),
+    m_streamPath(""),
+    m_streamFormat("csv"),
+    m_writer(nullptr),
+    m_parts()
   {
     G4cout << "Creating Run" << G4endl;
   }
 
   Run::~Run() {
     G4cout << "Deleting Run" << G4endl;
+    delete m_writer;
   }
 
   void Run::RecordEvent(G4Event const* event) {
@@ -36,6 +56,10 @@ namespace ne697 {
       return;
     }
     /****** GEANT4 BOILERPLATE ******/
+    auto fill_energy = m_binning[EnergyHist].enabled();
+    auto fill_time = m_binning[TimeHist].enabled();
+    auto fill_radius = m_binning[RadiusHist].enabled();
+    m_eventEdep.clear();
     // Ok, now we've got the container (which is a pointer)
     //G4cout << "Event had " << hc->entries() << " hits" << G4endl;
     for (std::size_t ihit = 0; ihit < hc->entries(); ++ihit) {
@@ -65,7 +89,51 @@ namespace ne697 {
             << G4endl;
 	    */
 
-      m_hits.push_back(*hit_in);
+      if (fill_energy) {
+        auto found = std::find_if(m_eventEdep.begin(), m_eventEdep.end(),
+            [&](std::pair<G4int, G4double> const& entry) {
+              return entry.first == hit_in->getVolumeID();
+            });
+        if (found == m_eventEdep.end()) {
+          m_eventEdep.emplace_back(hit_in->getVolumeID(), hit_in->getEnergy());
+        } else {
+          found->second += hit_in->getEnergy();
+        }
+      }
+      if (fill_time) {
+        histogram(TimeHist, hit_in->getVolumeID()).fill(hit_in->getTime(),
+            hit_in->getWeight());
+      }
+      if (fill_radius) {
+        histogram(RadiusHist, hit_in->getVolumeID())
+            .fill(hit_in->getPosition().perp(), hit_in->getWeight());
+      }
+
+      if (m_streamPath.empty()) {
+        if (!m_fStoreHits) {
+          continue;
+        }
+        if (m_hits.empty()) {
+          m_hits.emplace_back();
+        }
+        m_hits.back().push_back(*hit_in);
+      } else {
+        if (!m_writer) {
+          auto thread_id = G4Threading::G4GetThreadId();
+          m_writer = HitWriter::create(m_streamFormat, m_streamPath + ".part" +
+              (thread_id < 0 ? G4String("master") : std::to_string(thread_id)),
+              false);
+        }
+        m_writer->write(*hit_in);
+      }
+    }
+
+    // The summed energy belongs to the whole event, so it gets the
+    // primary's weight (1 unless the source direction is biased)
+    auto const weight = event->GetNumberOfPrimaryVertex() > 0 ?
+      event->GetPrimaryVertex()->GetWeight() : 1.;
+    for (auto const& entry : m_eventEdep) {
+      histogram(EnergyHist, entry.first).fill(entry.second, weight);
     }
 
     // Don't forget to call the base class RecordEvent! Geant4 does some
@@ -75,18 +143,130 @@ namespace ne697 {
   }
 
   void Run::Merge(G4Run const* from_run) {
-    auto other_run = dynamic_cast<Run const*>(from_run);
-    auto hits = other_run->get_hits();
-    for (auto& hit : hits) {
-      m_hits.push_back(hit);
+    auto start = std::chrono::steady_clock::now();
+    // Geant4 hands us the worker's run as const, and it isn't deleted after
+    // the merge: the worker's EndOfRunAction() still gets it, and it lives
+    // until the next run starts. Stealing its hits and part files instead
+    // of copying is only safe because the worker side of
+    // RunAction::EndOfRunAction() never looks at them; anything added there
+    // would see an empty run
+    auto other_run = const_cast<Run*>(dynamic_cast<Run const*>(from_run));
+    m_hits.reserve(m_hits.size() + other_run->m_hits.size());
+    for (auto& chunk : other_run->m_hits) {
+      m_hits.push_back(std::move(chunk));
     }
+    other_run->m_hits.clear();
+    // The worker is done with its part file by now, so take ownership of it
+    auto parts = other_run->close_stream();
+    m_parts.insert(m_parts.end(), parts.begin(), parts.end());
+    for (int type = 0; type < n_histograms; ++type) {
+      for (auto const& entry : other_run->m_histograms[type]) {
+        auto found = m_histograms[type].find(entry.first);
+        if (found == m_histograms[type].end()) {
+          m_histograms[type].emplace(entry);
+        } else {
+          found->second.add(entry.second);
+        }
+      }
+    }
+
+    m_timedEvents += other_run->m_timedEvents;
+    m_eventTimeSum += other_run->m_eventTimeSum;
+    m_eventTimeSum2 += other_run->m_eventTimeSum2;
+    m_eventTimeMax = std::max(m_eventTimeMax, other_run->m_eventTimeMax);
+
+    std::chrono::duration<G4double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    m_mergeTime += elapsed.count();
+    ++m_mergeCount;
 
     // Don't forget to call the base class Merge! Geant4 does some bookkeeping
     G4Run::Merge(from_run);
     return;
   }
 
-  std::vector<Hit> Run::get_hits() const {
+  HitChunks const& Run::get_hits() const {
     return m_hits;
   }
+
+  std::size_t Run::get_hit_count() const {
+    std::size_t count = 0;
+    for (auto const& chunk : m_hits) {
+      count += chunk.size();
+    }
+    return count;
+  }
+
+  G4double Run::get_merge_time() const {
+    return m_mergeTime;
+  }
+
+  G4int Run::get_merge_count() const {
+    return m_mergeCount;
+  }
+
+  void Run::add_event_time(G4double time) {
+    ++m_timedEvents;
+    m_eventTimeSum += time;
+    m_eventTimeSum2 += time*time;
+    m_eventTimeMax = std::max(m_eventTimeMax, time);
+    return;
+  }
+
+  G4int Run::get_timed_events() const {
+    return m_timedEvents;
+  }
+
+  G4double Run::get_event_time_mean() const {
+    return m_timedEvents > 0 ? m_eventTimeSum/m_timedEvents : 0.;
+  }
+
+  G4double Run::get_event_time_rms() const {
+    if (m_timedEvents == 0) {
+      return 0.;
+    }
+    auto mean = get_event_time_mean();
+    return std::sqrt(std::max(m_eventTimeSum2/m_timedEvents - mean*mean, 0.));
+  }
+
+  G4double Run::get_event_time_max() const {
+    return m_eventTimeMax;
+  }
+
+  void Run::set_stream(G4String const& path, G4String const& format) {
+    m_streamPath = path;
+    m_streamFormat = format;
+    return;
+  }
+
+  void Run::store_hits(bool store) {
+    m_fStoreHits = store;
+    return;
+  }
+
+  void Run::set_histogram(HistogramType type, Histogram const& binning) {
+    m_binning[type] = binning;
+    return;
+  }
+
+  Run::VolumeHistograms const& Run::get_histograms(HistogramType type) const {
+    return m_histograms[type];
+  }
+
+  Histogram& Run::histogram(HistogramType type, G4int volume_id) {
+    auto found = m_histograms[type].find(volume_id);
+    if (found == m_histograms[type].end()) {
+      found = m_histograms[type].emplace(volume_id, m_binning[type]).first;
+    }
+    return found->second;
+  }
+
+  std::vector<HitPart> Run::close_stream() const {
+    auto parts = m_parts;
+    if (m_writer) {
+      m_writer->close();
+      parts.push_back({m_writer->get_path(), m_writer->get_count()});
+    }
+    return parts;
+  }
 }
@@ -1,15 +1,22 @@
 #include "runaction.hpp"
 #include "globals.hh"
 #include "run.hpp"
+#include <cstdio>
 #include <fstream>
+#include <sys/resource.h>
 #include "G4SystemOfUnits.hh"
 #include "runmessenger.hpp"
+#include "stringtable.hpp"
 
 namespace ne697 {
   RunAction::RunAction():
     G4UserRunAction(),
     m_fSaveData(true),
-    m_path("hits.csv")
+    m_fStreamHits(false),
+    m_path("hits.csv"),
+    m_format("csv"),
+    m_histograms(),
+    m_histogramPath("histograms.csv")
     {
       G4cout << "Creating RunAction" << G4endl;
       m_messenger = new RunMessenger(this);
@@ -21,7 +28,15 @@ namespace ne697 {
   }
 
   G4Run* RunAction::GenerateRun() {
-    return new Run;
+    auto run = new Run;
+    if (m_fSaveData && m_fStreamHits) {
+      run->set_stream(m_path, m_format);
+    }
+    run->store_hits(m_fSaveData);
+    for (int type = 0; type < Run::n_histograms; ++type) {
+      run->set_histogram(Run::HistogramType(type), m_histograms[type]);
+    }
+    return run;
   }
   void RunAction::BeginOfRunAction(G4Run const*) {
     G4cout << "Starting a run!" << G4endl;
@@ -40,11 +55,30 @@ namespace ne697 {
     }
     G4cout << "Finished processing " << nevents << " events" << G4endl;
     // We don't want to do this in every thread, just the master one!
+    // (Workers couldn't anyway: Run::Merge() has already taken their hits)
     if (IsMaster()) {
-      if (m_fSaveData) {
+      // ru_maxrss is in kilobytes on Linux
+      rusage usage;
+      getrusage(RUSAGE_SELF, &usage);
+      G4cout << "Merged " << our_run->get_merge_count() << " worker runs in "
+        << our_run->get_merge_time() << " ms, " << our_run->get_hit_count()
+        << " hits in memory, peak RSS " << usage.ru_maxrss / 1024. << " MB"
+        << G4endl;
+      // Compare these between geometry backends (see scripts/bench_*.mac)
+      G4cout << "Event CPU time over " << our_run->get_timed_events()
+        << " events: mean " << our_run->get_event_time_mean() << " ms, rms "
+        << our_run->get_event_time_rms() << " ms, max "
+        << our_run->get_event_time_max() << " ms, total "
+        << our_run->get_event_time_mean()*our_run->get_timed_events()/1000.
+        << " s" << G4endl;
+      if (m_fSaveData && m_fStreamHits) {
+        G4cout << "Merging streamed hits..." << G4endl;
+        merge_parts(our_run->close_stream());
+      } else if (m_fSaveData) {
         G4cout << "Writing hits..." << G4endl;
         write_hits(our_run->get_hits());
       }
+      write_histograms(our_run);
     }
     return;
   }
@@ -67,27 +101,101 @@ namespace ne697 {
     return;
   }
 
-  void RunAction::write_hits(std::vector<Hit> hits) {
-    std::ofstream out_file(m_path);
-    out_file << "eventID,trackID,parentID,particle,creator_process,volume,";
-    out_file << "x[cm],y[cm],z[cm],energy_dep[keV],time[ns]" << std::endl;
-    for (std::size_t i=0;i < hits.size();++i) {
-      auto hit = hits[i];
-      out_file << hit.getEventID() << ",";
-      out_file << hit.getTrackID() << ",";
-      out_file << hit.getParentID() << ",";
-      out_file << hit.getParticle() << ",";
-      out_file << hit.getProcess() << ",";
-      out_file << hit.getVolume() << ",";
-      // This is where we take our units back out - the number will be in
-      // whatever units we divide by
-      out_file << hit.getPosition().getX() / cm << ",";
-      out_file << hit.getPosition().getY() / cm << ",";
-      out_file << hit.getPosition().getZ() / cm << ",";
-      out_file << hit.getEnergy() / keV << ",";
-      out_file << hit.getTime() / ns << std::endl;
+  bool RunAction::stream_hits() const {
+    return m_fStreamHits;
+  }
+
+  void RunAction::stream_hits(bool stream) {
+    m_fStreamHits = stream;
+    return;
+  }
+
+  G4String const& RunAction::get_format() const {
+    return m_format;
+  }
+
+  void RunAction::set_format(G4String const& format) {
+    m_format = format;
+    return;
+  }
+
+  Histogram const& RunAction::get_histogram(Run::HistogramType type) const {
+    return m_histograms[type];
+  }
+
+  void RunAction::set_histogram(Run::HistogramType type,
+      Histogram const& binning) {
+    m_histograms[type] = binning;
+    return;
+  }
+
+  G4String const& RunAction::get_histogram_path() const {
+    return m_histogramPath;
+  }
+
+  void RunAction::set_histogram_path(G4String const& path) {
+    m_histogramPath = path;
+    return;
+  }
+
+  void RunAction::write_hits(HitChunks const& hits) {
+    auto writer = HitWriter::create(m_format, m_path);
+    for (auto const& chunk : hits) {
+      for (auto const& hit : chunk) {
+        writer->write(hit);
+      }
+    }
+    writer->close();
+    delete writer;
+    return;
+  }
+
+  void RunAction::write_histograms(Run const* run) {
+    // Same names and units as the hits.csv columns
+    static char const* const names[Run::n_histograms] = {
+      "energy_dep[keV]", "time[ns]", "radius[cm]"
+    };
+    static G4double const units[Run::n_histograms] = {keV, ns, cm};
+    bool any = false;
+    for (auto const& binning : m_histograms) {
+      any = any || binning.enabled();
+    }
+    if (!any) {
+      return;
+    }
+    std::ofstream out_file(m_histogramPath);
+    out_file << "histogram,volume,bin,low,high,entries,sumw2\n";
+    for (int type = 0; type < Run::n_histograms; ++type) {
+      for (auto const& entry :
+          run->get_histograms(Run::HistogramType(type))) {
+        entry.second.write(out_file, G4String(names[type]) + "," +
+            StringTable::lookup(entry.first), units[type]);
+      }
     }
     out_file.close();
+    G4cout << "Wrote histograms to " << m_histogramPath << G4endl;
+    return;
+  }
+
+  void RunAction::merge_parts(std::vector<HitPart> const& parts) {
+    auto writer = HitWriter::create(m_format, m_path);
+    // One line per part: where its rows start in the merged file, both as a
+    // row number and as a byte offset, so readers can seek straight to it
+    std::ofstream index_file(m_path + ".idx");
+    index_file << "part,first_row,rows,offset[bytes]\n";
+    std::size_t first_row = 0;
+    for (std::size_t i=0;i < parts.size();++i) {
+      index_file << i << "," << first_row << "," << parts[i].count << ","
+        << writer->tell() << "\n";
+      writer->append(parts[i]);
+      std::remove(parts[i].path.c_str());
+      first_row += parts[i].count;
+    }
+    writer->close();
+    delete writer;
+    index_file.close();
+    G4cout << "Merged " << first_row << " hits from " << parts.size()
+      << " part files into " << m_path << G4endl;
     return;
   }
 }
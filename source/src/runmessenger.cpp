@@ -1,5 +1,8 @@
 #include "runmessenger.hpp"
 #include "runaction.hpp"
+#include "G4UIparameter.hh"
+#include "G4UnitsTable.hh"
+#include <sstream>
 
 namespace ne697 {
   RunMessenger::RunMessenger(RunAction* runaction):
@@ -22,12 +25,63 @@ namespace ne697 {
       m_savePathCmd->SetParameterName("save_path", true);
       m_savePathCmd->SetDefaultValue(m_runAction->get_path());
       m_savePathCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+      // Stream hits to disk during the run: /ne697/run/stream_hits
+      m_streamHitsCmd = new G4UIcmdWithABool("/ne697/run/stream_hits", this);
+      m_streamHitsCmd->SetGuidance("Write hits out per thread as events are processed,");
+      m_streamHitsCmd->SetGuidance("instead of holding them all until the end of the run.");
+      m_streamHitsCmd->SetParameterName("stream_hits", true);
+      m_streamHitsCmd->SetDefaultValue(m_runAction->stream_hits());
+      m_streamHitsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+      // Output format: /ne697/run/format
+      m_formatCmd = new G4UIcmdWithAString("/ne697/run/format", this);
+      m_formatCmd->SetGuidance("Hit output format.");
+      m_formatCmd->SetGuidance("'csv' is plain text, 'columnar' is a binary file with one");
+      m_formatCmd->SetGuidance("array per column, written in row groups.");
+      m_formatCmd->SetParameterName("format", true);
+      m_formatCmd->SetCandidates("csv columnar");
+      m_formatCmd->SetDefaultValue(m_runAction->get_format());
+      m_formatCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+      // Histogram binning: /ne697/run/histogram
+      m_histogramCmd = new G4UIcommand("/ne697/run/histogram", this);
+      m_histogramCmd->SetGuidance("Fill a histogram per volume during the run and write it");
+      m_histogramCmd->SetGuidance("to histogram_path at the end. energy is the deposited energy");
+      m_histogramCmd->SetGuidance("summed per volume per event; time and radius (from the z");
+      m_histogramCmd->SetGuidance("axis) are filled per hit. nbins = 0 turns it off.");
+      m_histogramCmd->SetGuidance("Entries are summed weights, with their squares in sumw2.");
+      auto param = new G4UIparameter("type", 's', false);
+      param->SetParameterCandidates("energy time radius");
+      m_histogramCmd->SetParameter(param);
+      param = new G4UIparameter("nbins", 'i', false);
+      param->SetParameterRange("nbins >= 0");
+      m_histogramCmd->SetParameter(param);
+      param = new G4UIparameter("min", 'd', false);
+      m_histogramCmd->SetParameter(param);
+      param = new G4UIparameter("max", 'd', false);
+      m_histogramCmd->SetParameter(param);
+      param = new G4UIparameter("unit", 's', false);
+      m_histogramCmd->SetParameter(param);
+      m_histogramCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+      // Histogram file path: /ne697/run/histogram_path
+      m_histogramPathCmd = new G4UIcmdWithAString("/ne697/run/histogram_path",
+          this);
+      m_histogramPathCmd->SetGuidance("Histogram file path.");
+      m_histogramPathCmd->SetParameterName("histogram_path", true);
+      m_histogramPathCmd->SetDefaultValue(m_runAction->get_histogram_path());
+      m_histogramPathCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
     }
 
   RunMessenger::~RunMessenger() {
     delete m_directory;
     delete m_saveDataCmd;
     delete m_savePathCmd;
+    delete m_streamHitsCmd;
+    delete m_formatCmd;
+    delete m_histogramCmd;
+    delete m_histogramPathCmd;
   }
 
   void RunMessenger::SetNewValue(G4UIcommand* cmd, G4String val) {
@@ -39,6 +93,46 @@ namespace ne697 {
     } else if (cmd == m_savePathCmd) {
       m_runAction->set_path(val);
       G4cout << "Save file path set to " << val << G4endl;
+    } else if (cmd == m_streamHitsCmd) {
+      bool parsed_val = m_streamHitsCmd->GetNewBoolValue(val);
+      m_runAction->stream_hits(parsed_val);
+      G4cout << "Stream hits set to " << (parsed_val ? "true" : "false")
+        << G4endl;
+    } else if (cmd == m_formatCmd) {
+      m_runAction->set_format(val);
+      G4cout << "Output format set to " << val << G4endl;
+    } else if (cmd == m_histogramCmd) {
+      std::istringstream val_stream(val);
+      G4String type, unit;
+      G4int nbins;
+      G4double min, max;
+      if (!(val_stream >> type >> nbins >> min >> max >> unit)) {
+        G4cerr << "Error: Expected <type> <nbins> <min> <max> <unit>" << G4endl;
+        return;
+      }
+      auto hist_type = type == "energy" ? Run::EnergyHist
+        : type == "time" ? Run::TimeHist : Run::RadiusHist;
+      // ValueOf() of an unknown unit is 0, which would put every fill in
+      // the overflow bin
+      G4String category = type == "energy" ? "Energy"
+        : type == "time" ? "Time" : "Length";
+      if (G4UnitDefinition::GetCategory(unit) != category) {
+        G4cerr << "Error: " << unit << " isn't a " << category << " unit"
+          << G4endl;
+        return;
+      }
+      if (nbins > 0 && max <= min) {
+        G4cerr << "Error: Histogram max must be larger than min" << G4endl;
+        return;
+      }
+      auto unit_value = G4UIcommand::ValueOf(unit);
+      m_runAction->set_histogram(hist_type,
+          Histogram(nbins, min*unit_value, max*unit_value));
+      G4cout << "Histogram " << type << " set to " << nbins << " bins from "
+        << min << " to " << max << " " << unit << G4endl;
+    } else if (cmd == m_histogramPathCmd) {
+      m_runAction->set_histogram_path(val);
+      G4cout << "Histogram file path set to " << val << G4endl;
     }
     // Command didn't match
     return;
@@ -0,0 +1,89 @@
+#include "sdmessenger.hpp"
+#include "sensitivedetector.hpp"
+#include "G4Threading.hh"
+#include "G4UnitsTable.hh"
+
+namespace ne697 {
+  SDMessenger::SDMessenger(SensitiveDetector* sd):
+    m_sd(sd)
+  {
+    // Directory: /ne697/sd
+    // The SensitiveDetector only exists after /run/initialize, so in
+    // sequential mode these commands have to come after it in a macro
+    m_directory = new G4UIdirectory("/ne697/sd/");
+    m_directory->SetGuidance("Choose which steps in the sensitive detector become hits.");
+
+    // Particles to record: /ne697/sd/particles
+    m_particlesCmd = new G4UIcmdWithAString("/ne697/sd/particles", this);
+    m_particlesCmd->SetGuidance("Space-separated list of particle names to record hits for.");
+    m_particlesCmd->SetGuidance("'all' records every particle.");
+    m_particlesCmd->SetParameterName("particles", true);
+    m_particlesCmd->SetDefaultValue(m_sd->get_particles());
+    m_particlesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Energy deposit threshold: /ne697/sd/min_edep
+    m_minEdepCmd = new G4UIcmdWithADoubleAndUnit("/ne697/sd/min_edep", this);
+    m_minEdepCmd->SetGuidance("Only steps depositing more than this become hits.");
+    m_minEdepCmd->SetParameterName("edep", true);
+    m_minEdepCmd->SetDefaultValue(m_sd->get_min_edep());
+    m_minEdepCmd->SetDefaultUnit("keV");
+    m_minEdepCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Logical volumes to record: /ne697/sd/volumes
+    m_volumesCmd = new G4UIcmdWithAString("/ne697/sd/volumes", this);
+    m_volumesCmd->SetGuidance("Space-separated list of logical volume names to record hits in.");
+    m_volumesCmd->SetGuidance("'all' records every sensitive volume.");
+    m_volumesCmd->SetParameterName("volumes", true);
+    m_volumesCmd->SetDefaultValue(m_sd->get_volumes());
+    m_volumesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // One hit per volume per event: /ne697/sd/aggregate
+    m_aggregateCmd = new G4UIcmdWithABool("/ne697/sd/aggregate", this);
+    m_aggregateCmd->SetGuidance("Sum the deposited energy per volume and record one hit");
+    m_aggregateCmd->SetGuidance("per volume per event instead of one hit per step.");
+    m_aggregateCmd->SetGuidance("The particle/volume/min_edep filters still apply.");
+    m_aggregateCmd->SetParameterName("aggregate", true);
+    m_aggregateCmd->SetDefaultValue(m_sd->get_aggregate());
+    m_aggregateCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  }
+
+  SDMessenger::~SDMessenger() {
+    delete m_directory;
+    delete m_particlesCmd;
+    delete m_minEdepCmd;
+    delete m_volumesCmd;
+    delete m_aggregateCmd;
+  }
+
+  void SDMessenger::SetNewValue(G4UIcommand* cmd, G4String val) {
+    // The master's copy (see WorkerCommands) is only there to check the
+    // command; the workers' copies act on it
+    if (G4Threading::IsMultithreadedApplication() &&
+        G4Threading::IsMasterThread()) {
+      return;
+    }
+    if (cmd == m_particlesCmd) {
+      m_sd->set_particles(val);
+      G4cout << "Recording hits for particles: " << m_sd->get_particles()
+        << G4endl;
+    } else if (cmd == m_minEdepCmd) {
+      G4double parsed_val = m_minEdepCmd->GetNewDoubleValue(val);
+      if (parsed_val < 0.0)
+        { G4cerr << "Error: Energy threshold must not be negative!" << G4endl; return; }
+
+      m_sd->set_min_edep(parsed_val);
+      G4cout << "Hit energy threshold set to "
+        << G4BestUnit(parsed_val, "Energy") << G4endl;
+    } else if (cmd == m_volumesCmd) {
+      m_sd->set_volumes(val);
+      G4cout << "Recording hits in volumes: " << m_sd->get_volumes() << G4endl;
+    } else if (cmd == m_aggregateCmd) {
+      bool parsed_val = m_aggregateCmd->GetNewBoolValue(val);
+      m_sd->set_aggregate(parsed_val);
+      G4cout << "Aggregate hits per volume set to "
+        << (parsed_val ? "true" : "false") << G4endl;
+    }
+    // Command didn't match
+    return;
+  }
+}
@@ -1,17 +1,42 @@
 #include "sensitivedetector.hpp"
 #include "G4UnitsTable.hh"
 #include "G4VProcess.hh"
+#include "G4Gamma.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4ParticleTable.hh"
+#include "sdmessenger.hpp"
+#include "stringtable.hpp"
+#include <algorithm>
+#include <sstream>
 
 namespace ne697 {
-  SensitiveDetector::SensitiveDetector(G4String const& name):
+  SensitiveDetector::SensitiveDetector(G4String const& name,
+      std::vector<G4LogicalVolume*> const& volumes):
     G4VSensitiveDetector(name),
     m_id(-1),
-    m_hitsCollection(nullptr)
+    m_hitsCollection(nullptr),
+    // By default, only gammas that actually deposit energy make hits
+    m_particles({G4Gamma::Definition()}),
+    m_minEdep(0.),
+    m_volumes(),
+    m_volumeNames("all"),
+    m_fAggregate(false),
+    m_trackedVols(volumes.begin(), volumes.end()),
+    m_sumEdep(volumes.size(), 0.),
+    m_sumPosition(volumes.size()),
+    m_firstTime(volumes.size(), 0.),
+    m_volumeIDs(volumes.size(), -1),
+    m_weights(volumes.size(), 1.)
     {
       /****** GEANT4 BOILERPLATE ******/
       G4String hc_name = name + "_hits";
       collectionName.insert(hc_name);
       /****** GEANT4 BOILERPLATE ******/
+      m_messenger = new SDMessenger(this);
+    }
+
+    SensitiveDetector::~SensitiveDetector() {
+      delete m_messenger;
     }
 
     void SensitiveDetector::Initialize(G4HCofThisEvent* hc) {
@@ -26,26 +51,175 @@ namespace ne697 {
       // in Run::RecordEvent()
       hc->AddHitsCollection(m_id, m_hitsCollection);
       /****** GEANT4 BOILERPLATE ******/
+      if (m_fAggregate) {
+        std::fill(m_sumEdep.begin(), m_sumEdep.end(), 0.);
+        std::fill(m_sumPosition.begin(), m_sumPosition.end(), G4ThreeVector());
+      }
       return;
     }
 
     bool SensitiveDetector::ProcessHits(G4Step* step, G4TouchableHistory*) {
+        // Cheapest checks first, and all of them before we allocate anything
+        if (step->GetTotalEnergyDeposit() <= m_minEdep) {
+          return false;
+        }
         auto track = step->GetTrack();
+        if (!m_particles.empty() &&
+            std::find(m_particles.begin(), m_particles.end(),
+                      track->GetDefinition()) == m_particles.end()) {
+          return false;
+        }
+        auto volume =
+            step->GetPreStepPoint()->GetPhysicalVolume()->GetLogicalVolume();
+        if (!m_volumes.empty() &&
+            std::find(m_volumes.begin(), m_volumes.end(), volume) ==
+                m_volumes.end()) {
+          return false;
+        }
+
+        if (m_fAggregate) {
+          auto index = std::find(m_trackedVols.begin(), m_trackedVols.end(),
+                                 volume) - m_trackedVols.begin();
+          if (index == (long)m_trackedVols.size()) {
+            return false;
+          }
+          auto edep = step->GetTotalEnergyDeposit();
+          if (m_sumEdep[index] == 0.) {
+            m_firstTime[index] = track->GetGlobalTime();
+            m_volumeIDs[index] = StringTable::intern(track->GetVolume()->GetName());
+            m_weights[index] = track->GetWeight();
+          } else if (track->GetGlobalTime() < m_firstTime[index]) {
+            m_firstTime[index] = track->GetGlobalTime();
+          }
+          m_sumEdep[index] += edep;
+          m_sumPosition[index] += edep*track->GetPosition();
+          return true;
+        }
+
         // "must use class tag", G4VSensitiveDetector has a member function
         // called Hit() so this would be ambiguous
+        static G4String const generator("generator");
         auto hit = new ne697::Hit(
-            track->GetTrackID(), track->GetParentID(), track->GetVolume()->GetName(),
-            track->GetDefinition()->GetParticleName(),
-            (track->GetCreatorProcess() ? track->GetCreatorProcess()->GetProcessName()
-                                        : "generator"),
+            track->GetTrackID(), track->GetParentID(),
+            StringTable::intern(track->GetVolume()->GetName()),
+            StringTable::intern(track->GetDefinition()->GetParticleName()),
+            StringTable::intern(track->GetCreatorProcess()
+                                    ? track->GetCreatorProcess()->GetProcessName()
+                                    : generator),
             track->GetPosition(), step->GetTotalEnergyDeposit(),
-            track->GetGlobalTime()
+            track->GetGlobalTime(), track->GetWeight()
         );
-        if(track->GetDefinition()->GetParticleName()== "gamma"&&step->GetTotalEnergyDeposit()>0.0)
-        {
-          // G4cout << "This is an electron"<< G4endl;
-          m_hitsCollection->insert(hit);
-        }
+        m_hitsCollection->insert(hit);
         return true;
     }
+
+    void SensitiveDetector::EndOfEvent(G4HCofThisEvent*) {
+      if (!m_fAggregate) {
+        return;
+      }
+      // One summary Hit per volume that saw any energy; Run::RecordEvent
+      // picks these up like any other Hit
+      static G4int const summed = StringTable::intern("summed");
+      for (std::size_t i = 0; i < m_trackedVols.size(); ++i) {
+        if (m_sumEdep[i] <= 0.) {
+          continue;
+        }
+        m_hitsCollection->insert(new ne697::Hit(
+            0, 0, m_volumeIDs[i], summed, summed,
+            m_sumPosition[i] / m_sumEdep[i], m_sumEdep[i], m_firstTime[i],
+            m_weights[i]));
+      }
+      return;
+    }
+
+    void SensitiveDetector::set_particles(G4String const& names) {
+      m_particles.clear();
+      std::istringstream name_stream(names);
+      std::string name;
+      while (name_stream >> name) {
+        if (name == "all") {
+          m_particles.clear();
+          break;
+        }
+        auto particle = G4ParticleTable::GetParticleTable()->FindParticle(name);
+        if (!particle) {
+          G4cerr << "Error: Unknown particle " << name << G4endl;
+          continue;
+        }
+        m_particles.push_back(particle);
+      }
+      return;
+    }
+
+    G4String SensitiveDetector::get_particles() const {
+      if (m_particles.empty()) {
+        return "all";
+      }
+      G4String names;
+      for (auto particle : m_particles) {
+        names += (names.empty() ? "" : " ") + particle->GetParticleName();
+      }
+      return names;
+    }
+
+    void SensitiveDetector::set_min_edep(G4double const& edep) {
+      m_minEdep = edep;
+      return;
+    }
+
+    G4double const& SensitiveDetector::get_min_edep() const {
+      return m_minEdep;
+    }
+
+    void SensitiveDetector::set_volumes(G4String const& names) {
+      m_volumes.clear();
+      m_volumeNames = names;
+      std::istringstream name_stream(names);
+      std::string name;
+      while (name_stream >> name) {
+        if (name == "all") {
+          m_volumes.clear();
+          break;
+        }
+        auto volume = G4LogicalVolumeStore::GetInstance()->GetVolume(name, false);
+        if (!volume) {
+          G4cerr << "Error: Unknown logical volume " << name << G4endl;
+          continue;
+        }
+        m_volumes.push_back(volume);
+      }
+      return;
+    }
+
+    void SensitiveDetector::set_tracked_volumes(
+        std::vector<G4LogicalVolume*> const& volumes) {
+      m_trackedVols.assign(volumes.begin(), volumes.end());
+      m_sumEdep.assign(volumes.size(), 0.);
+      m_sumPosition.assign(volumes.size(), G4ThreeVector());
+      m_firstTime.assign(volumes.size(), 0.);
+      m_volumeIDs.assign(volumes.size(), -1);
+      m_weights.assign(volumes.size(), 1.);
+      set_volumes(m_volumeNames);
+      return;
+    }
+
+    void SensitiveDetector::set_aggregate(bool aggregate) {
+      m_fAggregate = aggregate;
+      return;
+    }
+
+    bool SensitiveDetector::get_aggregate() const {
+      return m_fAggregate;
+    }
+
+    G4String SensitiveDetector::get_volumes() const {
+      if (m_volumes.empty()) {
+        return "all";
+      }
+      G4String names;
+      for (auto volume : m_volumes) {
+        names += (names.empty() ? "" : " ") + volume->GetName();
+      }
+      return names;
+    }
 }
@@ -0,0 +1,185 @@
+#include "spectrum.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include "G4UIcommand.hh"
+#include "G4UnitsTable.hh"
+#include "Randomize.hh"
+
+namespace ne697 {
+  namespace {
+    // Value times unit, or a negative number if unit isn't an energy unit
+    G4double to_energy(G4double value, G4String const& unit) {
+      if (G4UnitDefinition::GetCategory(unit) != "Energy") {
+        return -1.;
+      }
+      return value*G4UIcommand::ValueOf(unit);
+    }
+  }
+
+  Spectrum::Spectrum():
+    m_low(),
+    m_high(),
+    m_weights(),
+    m_table(),
+    m_fBuilt(true)
+  {}
+
+  void Spectrum::add_line(G4double energy, G4double weight) {
+    add_continuum(energy, energy, weight);
+    return;
+  }
+
+  void Spectrum::add_continuum(G4double low, G4double high, G4double weight) {
+    m_low.push_back(low);
+    m_high.push_back(high);
+    m_weights.push_back(weight);
+    m_fBuilt = false;
+    return;
+  }
+
+  bool Spectrum::load(G4String const& path) {
+    std::ifstream in_file(path);
+    if (!in_file.good()) {
+      G4cerr << "Error: Can't read spectrum file " << path << G4endl;
+      return false;
+    }
+    // Parsed into here first, so a bad file leaves the spectrum alone
+    Spectrum parsed;
+    std::string line;
+    G4int line_number = 0;
+    while (std::getline(in_file, line)) {
+      ++line_number;
+      std::istringstream tokens(line.substr(0, line.find('#')));
+      std::string type;
+      if (!(tokens >> type)) {
+        continue;
+      }
+      G4double low = 0., high = 0., weight = 0.;
+      std::string unit;
+      bool good = false;
+      if (type == "line") {
+        good = bool(tokens >> low >> unit >> weight);
+        high = low;
+      } else if (type == "continuum") {
+        good = bool(tokens >> low >> high >> unit >> weight);
+      }
+      low = to_energy(low, unit);
+      high = to_energy(high, unit);
+      if (!good || low < 0. || high < low || weight < 0.) {
+        G4cerr << "Error: " << path << ":" << line_number
+          << ": expected 'line <energy> <unit> <weight>' or 'continuum <low> "
+          << "<high> <unit> <weight>', with low <= high and weight >= 0"
+          << G4endl;
+        return false;
+      }
+      parsed.add_continuum(low, high, weight);
+    }
+    G4double total = 0.;
+    for (auto weight : parsed.m_weights) {
+      total += weight;
+    }
+    if (total <= 0.) {
+      G4cerr << "Error: Spectrum file " << path << " has no positive weights"
+        << G4endl;
+      return false;
+    }
+    m_low.insert(m_low.end(), parsed.m_low.begin(), parsed.m_low.end());
+    m_high.insert(m_high.end(), parsed.m_high.begin(), parsed.m_high.end());
+    m_weights.insert(m_weights.end(), parsed.m_weights.begin(),
+        parsed.m_weights.end());
+    m_fBuilt = false;
+    return true;
+  }
+
+  void Spectrum::clear() {
+    m_low.clear();
+    m_high.clear();
+    m_weights.clear();
+    m_table = AliasTable();
+    m_fBuilt = true;
+    return;
+  }
+
+  std::size_t Spectrum::size() const {
+    return m_weights.size();
+  }
+
+  bool Spectrum::empty() const {
+    return m_weights.empty();
+  }
+
+  G4double Spectrum::sample() {
+    build();
+    auto const i = m_table.sample();
+    if (m_high[i] == m_low[i]) {
+      return m_low[i];
+    }
+    return m_low[i] + G4UniformRand()*(m_high[i] - m_low[i]);
+  }
+
+  void Spectrum::build() {
+    if (!m_fBuilt) {
+      m_table = AliasTable(m_weights);
+      m_fBuilt = true;
+    }
+    return;
+  }
+
+  void Spectrum::test(G4int n_samples) {
+    if (empty() || n_samples <= 0) {
+      G4cerr << "Error: Nothing to test, the spectrum is empty" << G4endl;
+      return;
+    }
+    build();
+    using clock = std::chrono::steady_clock;
+
+    std::vector<G4long> counts(size(), 0);
+    auto start = clock::now();
+    for (G4int i = 0; i < n_samples; ++i) {
+      ++counts[m_table.sample()];
+    }
+    std::chrono::duration<G4double, std::nano> alias = clock::now() - start;
+
+    // What a histogram source does instead: search the cumulative weights
+    std::vector<G4double> cumulative(m_weights.size());
+    G4double total = 0.;
+    for (std::size_t i = 0; i < m_weights.size(); ++i) {
+      total += m_weights[i];
+      cumulative[i] = total;
+    }
+    std::size_t checksum = 0;
+    start = clock::now();
+    for (G4int i = 0; i < n_samples; ++i) {
+      checksum += std::upper_bound(cumulative.begin(), cumulative.end(),
+          G4UniformRand()*total) - cumulative.begin();
+    }
+    std::chrono::duration<G4double, std::nano> search = clock::now() - start;
+
+    // Pearson chi-square over the entries with any weight
+    G4double chi2 = 0.;
+    G4int ndf = -1;
+    for (std::size_t i = 0; i < counts.size(); ++i) {
+      G4double expected = n_samples*m_weights[i]/total;
+      if (expected > 0.) {
+        chi2 += (counts[i] - expected)*(counts[i] - expected)/expected;
+        ++ndf;
+      } else if (counts[i] > 0) {
+        G4cerr << "Error: Drew entry " << i << ", which has zero weight"
+          << G4endl;
+      }
+    }
+    G4cout << "Spectrum test over " << n_samples << " draws from " << size()
+      << " entries: chi2/ndf = " << chi2 << "/" << ndf;
+    if (ndf > 0) {
+      // Normal approximation; |z| much above 3 means something is wrong
+      G4cout << " (z = " << (chi2 - ndf)/std::sqrt(2.*ndf) << ")";
+    }
+    G4cout << G4endl << "  " << alias.count()/n_samples
+      << " ns/draw with the alias table, " << search.count()/n_samples
+      << " ns/draw searching the cumulative weights (checksum " << checksum
+      << ")" << G4endl;
+    return;
+  }
+}
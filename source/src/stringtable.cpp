@@ -0,0 +1,63 @@
+#include "stringtable.hpp"
+#include "G4AutoLock.hh"
+#include "G4ThreadLocalSingleton.hh"
+#include <atomic>
+#include <unordered_map>
+
+namespace ne697 {
+  namespace {
+    // Names live in fixed-size chunks that never move once allocated, which
+    // is what lets lookup() run without the lock while intern() appends
+    constexpr std::size_t chunk_size = 1024;
+    constexpr std::size_t max_chunks = 1024;
+
+    G4Mutex table_mutex = G4MUTEX_INITIALIZER;
+    std::unordered_map<std::string, G4int> table_ids;
+    G4String* table_chunks[max_chunks] = {nullptr};
+    std::atomic<std::size_t> table_size(0);
+
+    // Per-thread copy of the name -> id map. The singleton owns each
+    // thread's copy, so they're freed at exit instead of leaking
+    G4ThreadLocalSingleton<std::unordered_map<std::string, G4int>> thread_maps;
+  }
+
+  G4int StringTable::intern(G4String const& name) {
+    auto thread_ids = thread_maps.Instance();
+    auto found = thread_ids->find(name);
+    if (found != thread_ids->end()) {
+      return found->second;
+    }
+
+    G4AutoLock lock(&table_mutex);
+    auto found_id = table_ids.find(name);
+    G4int id;
+    if (found_id != table_ids.end()) {
+      id = found_id->second;
+    } else {
+      auto size = table_size.load(std::memory_order_relaxed);
+      if (size == chunk_size*max_chunks) {
+        G4Exception("StringTable::intern", "TableFull", FatalException,
+            "Too many distinct names were interned.");
+      }
+      if (size % chunk_size == 0) {
+        table_chunks[size / chunk_size] = new G4String[chunk_size];
+      }
+      table_chunks[size / chunk_size][size % chunk_size] = name;
+      id = size;
+      table_ids.emplace(name, id);
+      table_size.store(size + 1, std::memory_order_release);
+    }
+    lock.unlock();
+
+    thread_ids->emplace(name, id);
+    return id;
+  }
+
+  G4String const& StringTable::lookup(G4int id) {
+    return table_chunks[id / chunk_size][id % chunk_size];
+  }
+
+  std::size_t StringTable::size() {
+    return table_size.load(std::memory_order_acquire);
+  }
+}
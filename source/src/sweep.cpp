@@ -0,0 +1,119 @@
+#include "sweep.hpp"
+#include "sweepmessenger.hpp"
+#include <sstream>
+#include "G4RunManager.hh"
+#include "G4UImanager.hh"
+#include "runaction.hpp"
+
+namespace ne697 {
+  Sweep::Sweep():
+    m_parameter(""),
+    m_values(),
+    m_path("sweep.csv")
+  {
+    m_messenger = new SweepMessenger(this);
+  }
+
+  Sweep::~Sweep() {
+    delete m_messenger;
+  }
+
+  void Sweep::set_parameter(G4String const& command) {
+    m_parameter = command;
+    return;
+  }
+
+  G4String const& Sweep::get_parameter() const {
+    return m_parameter;
+  }
+
+  void Sweep::set_values(G4String const& values) {
+    m_values.clear();
+    std::istringstream value_stream(values);
+    std::string value;
+    while (std::getline(value_stream, value, ',')) {
+      auto first = value.find_first_not_of(" \t");
+      if (first == std::string::npos) {
+        continue;
+      }
+      m_values.push_back(value.substr(first,
+            value.find_last_not_of(" \t") - first + 1));
+    }
+    return;
+  }
+
+  G4String Sweep::get_values() const {
+    G4String values;
+    for (auto const& value : m_values) {
+      values += (values.empty() ? "" : ", ") + value;
+    }
+    return values;
+  }
+
+  void Sweep::set_path(G4String const& path) {
+    m_path = path;
+    return;
+  }
+
+  G4String const& Sweep::get_path() const {
+    return m_path;
+  }
+
+  bool Sweep::run(G4int n_events) {
+    if (m_parameter.empty() || m_values.empty()) {
+      G4cerr << "Error: Set /ne697/sweep/parameter and /ne697/sweep/values "
+        << "before /ne697/sweep/beamOn" << G4endl;
+      return false;
+    }
+    // Split "dir/hits.csv" into "dir/hits" and ".csv"
+    auto slash = m_path.find_last_of('/');
+    auto dot = m_path.find_last_of('.');
+    if (dot == std::string::npos ||
+        (slash != std::string::npos && dot < slash)) {
+      dot = m_path.size();
+    }
+    G4String stem = m_path.substr(0, dot);
+    G4String extension = m_path.substr(dot);
+
+    // Put the output paths back once the sweep is over, even if a run
+    // failed, so a later plain /run/beamOn doesn't overwrite the last
+    // sweep file. The master's RunAction has the same paths as the workers'
+    auto run_action = static_cast<RunAction const*>(
+        G4RunManager::GetRunManager()->GetUserRunAction());
+    G4String const restore[] = {
+      "/ne697/run/save_path " + run_action->get_path(),
+      "/ne697/run/histogram_path " + run_action->get_histogram_path()
+    };
+    auto success = run_values(n_events, stem, extension);
+    auto ui_manager = G4UImanager::GetUIpointer();
+    for (auto const& command : restore) {
+      ui_manager->ApplyCommand(command);
+    }
+    return success;
+  }
+
+  bool Sweep::run_values(G4int n_events, G4String const& stem,
+      G4String const& extension) {
+    auto ui_manager = G4UImanager::GetUIpointer();
+    for (std::size_t i = 0; i < m_values.size(); ++i) {
+      G4String prefix = stem + "_" + std::to_string(i);
+      G4String const commands[] = {
+        m_parameter + " " + m_values[i],
+        "/ne697/run/save_path " + prefix + extension,
+        "/ne697/run/histogram_path " + prefix + "_histograms.csv",
+        "/run/beamOn " + std::to_string(n_events)
+      };
+      G4cout << "Sweep run " << i + 1 << " of " << m_values.size() << ": "
+        << commands[0] << ", saving to " << prefix + extension << G4endl;
+      for (auto const& command : commands) {
+        auto status = ui_manager->ApplyCommand(command);
+        if (status != 0) {
+          G4cerr << "Error: Command \"" << command << "\" failed with status "
+            << status << G4endl;
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+}
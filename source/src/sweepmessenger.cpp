@@ -0,0 +1,87 @@
+#include "sweepmessenger.hpp"
+#include "sweep.hpp"
+
+namespace ne697 {
+  SweepMessenger::SweepMessenger(Sweep* sweep):
+    m_sweep(sweep)
+  {
+    // Directory: /ne697/sweep
+    // None of these are broadcast: the sweep only exists on the master, and
+    // the commands it applies are passed on to the workers as usual
+    m_directory = new G4UIdirectory("/ne697/sweep/", false);
+    m_directory->SetGuidance("Run a list of values of one command in a single process.");
+
+    // Swept command: /ne697/sweep/parameter
+    m_parameterCmd = new G4UIcmdWithAString("/ne697/sweep/parameter", this);
+    m_parameterCmd->SetGuidance("Full path of the command to sweep, e.g. /gun/energy.");
+    m_parameterCmd->SetGuidance("Geometry and material commands rebuild the geometry between runs.");
+    m_parameterCmd->SetGuidance("The command keeps the last swept value afterwards; the save and");
+    m_parameterCmd->SetGuidance("histogram paths go back to what they were before the sweep.");
+    m_parameterCmd->SetParameterName("command", false);
+    m_parameterCmd->SetToBeBroadcasted(false);
+    m_parameterCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Values: /ne697/sweep/values
+    m_valuesCmd = new G4UIcmdWithAString("/ne697/sweep/values", this);
+    m_valuesCmd->SetGuidance("Comma-separated values, one run each, e.g. 100 keV, 300 keV, 1 MeV.");
+    m_valuesCmd->SetParameterName("values", false);
+    m_valuesCmd->SetToBeBroadcasted(false);
+    m_valuesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Output path: /ne697/sweep/save_path
+    m_savePathCmd = new G4UIcmdWithAString("/ne697/sweep/save_path", this);
+    m_savePathCmd->SetGuidance("Hits file path; run i writes <stem>_<i><extension>.");
+    m_savePathCmd->SetParameterName("save_path", true);
+    m_savePathCmd->SetDefaultValue(m_sweep->get_path());
+    m_savePathCmd->SetToBeBroadcasted(false);
+    m_savePathCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+    // Run the sweep: /ne697/sweep/beamOn
+    m_beamOnCmd = new G4UIcmdWithAnInteger("/ne697/sweep/beamOn", this);
+    m_beamOnCmd->SetGuidance("Run this many events for each value.");
+    m_beamOnCmd->SetParameterName("n_events", false);
+    m_beamOnCmd->SetRange("n_events >= 0");
+    m_beamOnCmd->SetToBeBroadcasted(false);
+    m_beamOnCmd->AvailableForStates(G4State_Idle);
+  }
+
+  SweepMessenger::~SweepMessenger() {
+    delete m_directory;
+    delete m_parameterCmd;
+    delete m_valuesCmd;
+    delete m_savePathCmd;
+    delete m_beamOnCmd;
+  }
+
+  void SweepMessenger::SetNewValue(G4UIcommand* cmd, G4String val) {
+    if (cmd == m_parameterCmd) {
+      if (val[0] != '/') {
+        G4cerr << "Error: Sweep parameter must be a full command path"
+          << G4endl;
+        return;
+      }
+      m_sweep->set_parameter(val);
+      G4cout << "Sweep parameter set to " << val << G4endl;
+    }
+    if (cmd == m_valuesCmd) {
+      m_sweep->set_values(val);
+      G4cout << "Sweep values set to " << m_sweep->get_values() << G4endl;
+    }
+    if (cmd == m_savePathCmd) {
+      m_sweep->set_path(val);
+      G4cout << "Sweep save path set to " << val << G4endl;
+    }
+    if (cmd == m_beamOnCmd) {
+      // The UI only sees the status of this command, so a failed sub-run
+      // has to fail it too for macros and MacroRunner to stop
+      if (!m_sweep->run(m_beamOnCmd->GetNewIntValue(val))) {
+        G4ExceptionDescription message;
+        message << "Sweep stopped early";
+        cmd->CommandFailed(message);
+      }
+    }
+
+    // Command didn't match
+    return;
+  }
+}
@@ -0,0 +1,16 @@
+#include "workercommands.hpp"
+#include "pga.hpp"
+#include "sensitivedetector.hpp"
+
+namespace ne697 {
+  WorkerCommands::WorkerCommands():
+    m_pga(new PGA),
+    // Not registered with the G4SDManager, so it never sees a step
+    m_sd(new SensitiveDetector("world_sd", {}))
+  {}
+
+  WorkerCommands::~WorkerCommands() {
+    delete m_sd;
+    delete m_pga;
+  }
+}